@@ -0,0 +1,47 @@
+import re
+import subprocess
+import sys
+
+# Compare the fill orders of sudoku2 (-o) on the classes of the job list.
+# Needs a counting build:
+#   g++ -std=c++17 -O2 -march=native -DNO_PRINT original_code/sudoku2.cc -o sudoku2-count
+#   python3 bench_orders.py [binary] [classes] [part]
+# classes is the number of jobs to run from the top of joblist.txt (all by
+# default), part limits each job to one of the 10 choices for the first
+# column (0-9, a tenth of the work) or runs all of them with -1.
+
+ORDERS = ["columns-rows", "rows", "columns", "boxes", "constrained"]
+STATS = re.compile(r"(\S+): (\d+) nodes\s+(\S+) s")
+
+binary = sys.argv[1] if len(sys.argv) > 1 else "./sudoku2-count"
+classes = int(sys.argv[2]) if len(sys.argv) > 2 else None
+part = sys.argv[3] if len(sys.argv) > 3 else "0"
+
+with open("joblist.txt", "r") as joblist:
+    jobs = [line.split() for line in joblist.read().splitlines()[1:] if line]
+jobs = jobs[:classes]
+
+totals = {order: [0, 0.0] for order in ORDERS}
+print(f"{'class':28}" + "".join(f"{order:>26}" for order in ORDERS))
+for job in jobs:
+    mult, config = job[1], job[2].strip("'")
+    row = []
+    counts = set()
+    for order in ORDERS:
+        args = [binary, "-o", order, mult, config]
+        if part != "-1":
+            args.append(part)
+        result = subprocess.run(args, stdout=subprocess.PIPE,
+                                stderr=subprocess.PIPE, text=True)
+        _, nodes, seconds = STATS.search(result.stderr).groups()
+        counts.add(result.stdout.split()[-1])
+        totals[order][0] += int(nodes)
+        totals[order][1] += float(seconds)
+        row.append(f"{int(nodes):>16} {float(seconds):8.3f}s")
+    if len(counts) != 1:
+        sys.exit(f"error: the orders disagree on {config}: {counts}")
+    print(f"{config:28}" + "".join(f"{cell:>26}" for cell in row))
+
+print(f"{'total':28}" + "".join(f"{n:>16} {t:8.3f}s" for n, t in totals.values()))
+best = min(ORDERS, key=lambda order: totals[order][1])
+print(f"fastest: {best}")
@@ -1,9 +1,37 @@
 import os
 import subprocess
 import json
+import mmap
+import struct
+
+# band table written by `equiv -w bands.tbl`, see original_code/bandtable.h
+TABLE = "bands.tbl"
+HEADER = struct.Struct("8sII")
+ENTRY = struct.Struct("24sIIQ")
+MAGIC = b"SUDBAND\0"
+VERSION = 1
+
+
+def table_jobs():
+    # one job per class representative, i.e. per entry with a class size
+    with open(TABLE, "rb") as f:
+        table = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+    magic, version, count = HEADER.unpack_from(table, 0)
+    if magic != MAGIC or version != VERSION or len(table) < HEADER.size + count * ENTRY.size:
+        raise SystemExit(f"error: {TABLE} is not a band table of version {VERSION}")
+    jobs = []
+    for i in range(count):
+        _, _, eq_size, _ = ENTRY.unpack_from(
+            table, HEADER.size + i * ENTRY.size)
+        if eq_size:
+            jobs.append(f'./sudoku2 -t {TABLE} {i}')
+    return jobs
+
 
 with open("joblist.txt", "r") as joblist:
     jobs = joblist.read().splitlines()[1:]
+    if os.path.exists(TABLE):
+        jobs = table_jobs()
     puzzles = []
     for i, job in enumerate(jobs):
         cmd = f'{job}'
@@ -0,0 +1,91 @@
+/*
+ * Binary table of the 36288 normalized configurations of the first
+ * three boxes, written once by "sudoku_equiv -w file" and mapped into
+ * memory by the other tools, so none of them has to regenerate the
+ * configurations or parse them from the command line.
+ *
+ * The file is a band_header followed by count band_entry records in
+ * the order of sudoku_equiv's lookup table. Entries are fixed size and
+ * the file is mapped as is, so it is only meant to be read on the
+ * machine (endianness) that wrote it.
+ */
+
+#ifndef BANDTABLE_H
+#define BANDTABLE_H
+
+#include <stdint.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define BAND_MAGIC "SUDBAND"
+#define BAND_VERSION 1
+/* completion count of an entry that has not been counted yet */
+#define BAND_UNCOUNTED (~(uint64_t)0)
+
+struct band_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t count;
+};
+
+struct band_entry
+{
+    /* "abcdef,ghijkl,mnopqr" as in the job list, NUL padded */
+    char config[24];
+    /* index of the representative of the equivalence class */
+    uint32_t cls;
+    /* size of the equivalence class for representatives, 0 otherwise */
+    uint32_t eq_size;
+    /* number of completions, or BAND_UNCOUNTED */
+    uint64_t completions;
+};
+
+struct band_table
+{
+    band_header *header;
+    band_entry *entry;
+    size_t bytes;
+};
+
+/*
+ * map a table; writable maps it shared so that stored completion
+ * counts end up in the file. Returns false if the file is missing
+ * or not a table.
+ */
+static inline bool band_map(band_table &t, const char *path, bool writable)
+{
+    int fd = open(path, writable ? O_RDWR : O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(band_header)) {
+        close(fd);
+        return false;
+    }
+    void *p = mmap(0, st.st_size, writable ? PROT_READ|PROT_WRITE : PROT_READ,
+                   MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    t.header = (band_header *)p;
+    t.entry = (band_entry *)(t.header+1);
+    t.bytes = st.st_size;
+    if (std::memcmp(t.header->magic, BAND_MAGIC, 8) != 0 ||
+        t.header->version != BAND_VERSION ||
+        t.bytes < sizeof(band_header) + t.header->count*sizeof(band_entry)) {
+        munmap(p, t.bytes);
+        return false;
+    }
+    return true;
+}
+
+static inline void band_unmap(band_table &t)
+{
+    munmap(t.header, t.bytes);
+}
+
+#endif
@@ -0,0 +1,49 @@
+/*
+ * Print the grids of a stream written by "sudoku2 -z file", one per
+ * line as 81 digits.
+ *
+ * Usage:
+ * ./gridcat file [first [count]]
+ * ./gridcat - < file
+ *   (first needs a seekable file; - reads standard input in order)
+ *
+ * Compile (example):
+ * g++ -O2 gridcat.cc -o gridcat
+ */
+
+#include <iostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "gridstream.h"
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " file [first [count]]" << std::endl;
+        return 1;
+    }
+    std::FILE *f = std::strcmp(argv[1], "-") == 0 ? stdin : std::fopen(argv[1], "rb");
+    grid_stream s;
+    if (!f || !grid_open(s, f)) {
+        std::cerr << "error: can't read grid stream " << argv[1] << std::endl;
+        return 1;
+    }
+    unsigned long long first = argc > 2 ? std::strtoull(argv[2], 0, 10) : 0;
+    unsigned long long count = argc > 3 ? std::strtoull(argv[3], 0, 10) : ~0ULL;
+    if (first && !grid_seek(s, first)) {
+        std::cerr << "error: no grid " << first << std::endl;
+        return 1;
+    }
+
+    uint8_t grid[81];
+    char line[83];
+    line[81] = '\n';
+    line[82] = 0;
+    for (unsigned long long n=0; n<count && grid_read(s, grid); n++) {
+        for (int i=0; i<81; i++)
+            line[i] = '0' + grid[i];
+        std::fputs(line, stdout);
+    }
+    return 0;
+}
@@ -0,0 +1,225 @@
+/*
+ * Compact stream of complete grids, written by "sudoku2 -z file" and
+ * read back by gridcat.
+ *
+ * sudoku2 enumerates grids depth first, so a grid usually differs from
+ * the one before only in the last few cells it filled. Each record
+ * stores the number k of cells at the end that changed, taken in the
+ * fill order of the header, and then those k values; all of it packed
+ * in 4-bit nibbles, k in two of them. Every sync-th record starts on a
+ * byte boundary and holds a full grid (k = 81), and the trailer lists
+ * the offsets of these records for random access. k = 0xff ends the
+ * records.
+ *
+ * Layout: grid_header, records, uint64_t offsets[syncs], grid_trailer.
+ * Like bandtable.h this is only meant to be read on the machine
+ * (endianness) that wrote it.
+ */
+
+#ifndef GRIDSTREAM_H
+#define GRIDSTREAM_H
+
+#include <stdint.h>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#define GRID_MAGIC "SUDGRID"
+#define GRID_END "SUDGEND"
+#define GRID_VERSION 1
+#define GRID_SYNC 4096
+
+struct grid_header
+{
+    char magic[8];
+    uint32_t version;
+    /* a full grid every sync records */
+    uint32_t sync;
+    /* order[k] is the cell (row*9+column) stored k-th in a record */
+    uint8_t order[81];
+    uint8_t pad[7];
+};
+
+struct grid_trailer
+{
+    uint64_t count;
+    uint64_t syncs;
+    char magic[8];
+};
+
+/*
+ * state of a writer or reader: prev holds the last grid in fill order,
+ * count the number of grids written (or in the file, if known), index
+ * the next grid to read and bytes the size written so far
+ */
+struct grid_stream
+{
+    std::FILE *f;
+    grid_header header;
+    uint8_t prev[81];
+    uint64_t count, index, bytes;
+    std::vector<uint64_t> offsets;
+    int half, acc;
+};
+
+static inline void grid_put_nibble(grid_stream &s, int v)
+{
+    if (!s.half) {
+        s.acc = v << 4;
+        s.half = 1;
+    } else {
+        std::fputc(s.acc | v, s.f);
+        s.bytes++;
+        s.half = 0;
+    }
+}
+
+static inline void grid_align_out(grid_stream &s)
+{
+    if (s.half) {
+        std::fputc(s.acc, s.f);
+        s.bytes++;
+        s.half = 0;
+    }
+}
+
+static inline int grid_get_nibble(grid_stream &s)
+{
+    if (s.half) {
+        s.half = 0;
+        return s.acc & 15;
+    }
+    s.acc = std::fgetc(s.f);
+    if (s.acc == EOF)
+        return -1;
+    s.half = 1;
+    return s.acc >> 4;
+}
+
+/* start a stream with the given fill order; false if path can't be created */
+static inline bool grid_create(grid_stream &s, const char *path,
+                               const uint8_t *order, uint32_t sync = GRID_SYNC)
+{
+    s.f = std::fopen(path, "wb");
+    if (!s.f)
+        return false;
+    std::memset(&s.header, 0, sizeof(s.header));
+    std::memcpy(s.header.magic, GRID_MAGIC, 8);
+    s.header.version = GRID_VERSION;
+    s.header.sync = sync;
+    std::memcpy(s.header.order, order, 81);
+    std::fwrite(&s.header, sizeof(s.header), 1, s.f);
+    s.count = 0;
+    s.bytes = sizeof(s.header);
+    s.offsets.clear();
+    s.half = 0;
+    return true;
+}
+
+/* append a grid, values 1..9 in row major order */
+static inline void grid_write(grid_stream &s, const uint8_t *grid)
+{
+    uint8_t cur[81];
+    for (int k=0; k<81; k++)
+        cur[k] = grid[s.header.order[k]];
+    int p = 0;
+    if (s.count % s.header.sync == 0) {
+        grid_align_out(s);
+        s.offsets.push_back(s.bytes);
+    } else {
+        while (p < 81 && cur[p] == s.prev[p])
+            p++;
+    }
+    grid_put_nibble(s, (81-p) >> 4);
+    grid_put_nibble(s, (81-p) & 15);
+    for (int k=p; k<81; k++)
+        grid_put_nibble(s, cur[k]);
+    std::memcpy(s.prev, cur, 81);
+    s.count++;
+}
+
+/* write the end marker, the sync offsets and the trailer */
+static inline void grid_close(grid_stream &s)
+{
+    if (s.count % s.header.sync == 0)
+        grid_align_out(s);
+    grid_put_nibble(s, 15);
+    grid_put_nibble(s, 15);
+    grid_align_out(s);
+    if (!s.offsets.empty())
+        std::fwrite(&s.offsets[0], sizeof(uint64_t), s.offsets.size(), s.f);
+    grid_trailer t;
+    t.count = s.count;
+    t.syncs = s.offsets.size();
+    std::memcpy(t.magic, GRID_END, 8);
+    std::fwrite(&t, sizeof(t), 1, s.f);
+    std::fclose(s.f);
+}
+
+/*
+ * open a stream for reading. If the file is seekable the trailer is
+ * loaded as well, so count is known and grid_seek works; on a pipe
+ * count stays 0 and the records can only be read in order.
+ */
+static inline bool grid_open(grid_stream &s, std::FILE *f)
+{
+    s.f = f;
+    if (std::fread(&s.header, sizeof(s.header), 1, f) != 1 ||
+        std::memcmp(s.header.magic, GRID_MAGIC, 8) != 0 ||
+        s.header.version != GRID_VERSION || !s.header.sync)
+        return false;
+    s.count = 0;
+    s.offsets.clear();
+    grid_trailer t;
+    if (std::fseek(f, -(long)sizeof(t), SEEK_END) == 0 &&
+        std::fread(&t, sizeof(t), 1, f) == 1 &&
+        std::memcmp(t.magic, GRID_END, 8) == 0) {
+        s.count = t.count;
+        s.offsets.resize(t.syncs);
+        std::fseek(f, -(long)(sizeof(t) + t.syncs*sizeof(uint64_t)), SEEK_END);
+        if (t.syncs && std::fread(&s.offsets[0], sizeof(uint64_t), t.syncs, f) != t.syncs)
+            return false;
+        std::fseek(f, sizeof(s.header), SEEK_SET);
+    }
+    s.index = 0;
+    s.half = 0;
+    return true;
+}
+
+/* read the next grid into grid (row major, 1..9); false at the end */
+static inline bool grid_read(grid_stream &s, uint8_t *grid)
+{
+    if (s.index % s.header.sync == 0)
+        s.half = 0;
+    int hi = grid_get_nibble(s), lo = grid_get_nibble(s);
+    if (hi < 0 || lo < 0 || (hi<<4 | lo) > 81)
+        return false;
+    for (int k=81-(hi<<4 | lo); k<81; k++) {
+        int v = grid_get_nibble(s);
+        if (v < 1 || v > 9)
+            return false;
+        s.prev[k] = v;
+    }
+    for (int k=0; k<81; k++)
+        grid[s.header.order[k]] = s.prev[k];
+    s.index++;
+    return true;
+}
+
+/* position the reader at grid i (counting from 0); needs the trailer */
+static inline bool grid_seek(grid_stream &s, uint64_t i)
+{
+    uint64_t k = i / s.header.sync;
+    if (i >= s.count || k >= s.offsets.size() ||
+        std::fseek(s.f, s.offsets[k], SEEK_SET) != 0)
+        return false;
+    s.index = k * s.header.sync;
+    s.half = 0;
+    uint8_t grid[81];
+    while (s.index < i)
+        if (!grid_read(s, grid))
+            return false;
+    return true;
+}
+
+#endif
@@ -15,22 +15,41 @@
  *
  * Usage:
  * ./sudoku2 mult [[4,5,9,6,7,8],[7,8,3,9,2,1],[2,1,6,3,5,4]]
+ * ./sudoku2 -t table id
+ *   (configuration id of a table written by sudoku_equiv -w; the
+ *   multiplier comes from the table and the count is stored in it)
+ * ./sudoku2 -z file ...
+ *   (PRINT builds: write all grids to file in the format of
+ *   gridstream.h instead of printing the first 200)
+ * ./sudoku2 -o order ...
+ *   (fill the free cells in another built-in order, see orders[];
+ *   the nodes and time of the search go to stderr)
  *
  * Compile (example):
- * g++ -O2 -Wall -fomit-frame-pointer -march=athlon-xp sudoku2.cc -o sudoku2
+ * g++ -std=c++17 -O2 -Wall -fomit-frame-pointer -march=native sudoku2.cc -o sudoku2
+ *   (add -DNO_PRINT for a build that counts all grids)
  */
 
 #include <iostream>
+#include <array>
+#include <chrono>
 #include <cstdlib>
+#include <cstring>
+#include "bandtable.h"
+#include "gridstream.h"
 
 // #define DEBUG
+#ifndef NO_PRINT
 #define PRINT
+#endif
 
 /* bit masks of used numbers for the 9 columns, rows and boxes. */
 static int u[3][9];
 
 #ifdef PRINT
 static int v[9][9];
+/* grid stream for -z, or 0 */
+static grid_stream *zout;
 #endif
 
 /*
@@ -78,18 +97,142 @@ static inline void undo(int x, int y, int m)
     u[2][(x/3)*3+(y/3)] -= m;
 }
 
-static unsigned long long solutions;
+static unsigned long long solutions, nodes;
+/* configuration and multiplier, from the command line or a table */
+static const char *config, *mult;
+
+/* the last line of every run: configuration, multiplier and count */
+static void summary()
+{
+    std::cout << config << ": " << mult << " * " << solutions << std::endl;
+}
+
+/*
+ * the 48 cells left free by the first three rows and the first column,
+ * as (x, y) for place(), in the order search() fills them. The order is
+ * a compile time constant, so search() still unrolls into one function
+ * per cell with its coordinates folded in.
+ */
+struct cell
+{
+    int x, y;
+};
+#define FREE 48
+typedef std::array<cell, FREE> cell_order;
+
+/*
+ * first column, then first row, then second column, then second row and
+ * so on: the order of the original program
+ */
+constexpr cell_order columns_rows_order()
+{
+    cell_order o{};
+    int n = 0;
+    for (int x=8, y=1; !(x==8 && y==9); ) {
+        o[n++] = cell{x, y};
+        int x1 = x>y ? x==3 && y<3 ? 8   : x-1 : y==8 ? 8   : x;
+        int y1 = x>y ? x==3 && y<3 ? y+1 : y   : y==8 ? x+1 : y+1;
+        x = x1;
+        y = y1;
+    }
+    return o;
+}
+
+/* row by row */
+constexpr cell_order rows_order()
+{
+    cell_order o{};
+    int n = 0;
+    for (int x=3; x<9; x++)
+        for (int y=1; y<9; y++)
+            o[n++] = cell{x, y};
+    return o;
+}
+
+/* column by column */
+constexpr cell_order columns_order()
+{
+    cell_order o{};
+    int n = 0;
+    for (int y=1; y<9; y++)
+        for (int x=3; x<9; x++)
+            o[n++] = cell{x, y};
+    return o;
+}
+
+/* box by box, the boxes of the second band first, rows within a box */
+constexpr cell_order boxes_order()
+{
+    cell_order o{};
+    int n = 0;
+    for (int bx=3; bx<9; bx+=3)
+        for (int by=0; by<9; by+=3)
+            for (int x=bx; x<bx+3; x++)
+                for (int y=by; y<by+3; y++)
+                    if (y)
+                        o[n++] = cell{x, y};
+    return o;
+}
 
 /*
- * the purpose of using a template here is to profit from constant folding
- * and from function inlining.
+ * most constrained first, decided before the search: each step takes the
+ * free cell that sees the most filled cells in its row, column and box,
+ * the first one of them on ties
  */
-template <int x, int y> static inline void search();
+constexpr cell_order constrained_order()
+{
+    bool filled[9][9] = {};
+    for (int x=0; x<9; x++)
+        for (int y=0; y<9; y++)
+            filled[x][y] = x < 3 || y == 0;
+    cell_order o{};
+    for (int n=0; n<FREE; n++) {
+        int best = -1;
+        for (int x=3; x<9; x++)
+            for (int y=1; y<9; y++) {
+                if (filled[x][y])
+                    continue;
+                int seen = 0;
+                for (int a=0; a<9; a++)
+                    for (int b=0; b<9; b++)
+                        if (filled[a][b] && (a == x || b == y ||
+                                             (a/3 == x/3 && b/3 == y/3)))
+                            seen++;
+                if (seen > best) {
+                    best = seen;
+                    o[n] = cell{x, y};
+                }
+            }
+        filled[o[n].x][o[n].y] = true;
+    }
+    return o;
+}
+
+/* every free cell exactly once */
+constexpr bool complete(const cell_order &o)
+{
+    bool seen[9][9] = {};
+    for (int n=0; n<FREE; n++) {
+        if (o[n].x < 3 || o[n].x > 8 || o[n].y < 1 || o[n].y > 8 ||
+            seen[o[n].x][o[n].y])
+            return false;
+        seen[o[n].x][o[n].y] = true;
+    }
+    return true;
+}
+
+static constexpr cell_order columns_rows = columns_rows_order();
+static constexpr cell_order rows = rows_order();
+static constexpr cell_order columns = columns_order();
+static constexpr cell_order boxes = boxes_order();
+static constexpr cell_order constrained = constrained_order();
+static_assert(complete(columns_rows) && complete(rows) && complete(columns) &&
+              complete(boxes) && complete(constrained), "bad fill order");
 
 /*
  * we get here after placing all numbers --> count a solution.
  */
-template<> static inline void search<8, 9>()
+static inline void found()
 {
 #ifdef DEBUG
     for (int i=0; i<9; i++)
@@ -101,26 +244,39 @@ template<> static inline void search<8, 9>()
         }
 #endif
 #ifdef PRINT
-    for (int i=0; i<9; i++) {
-        for (int j=0; j<9; j++) {
-            int k;
-            for (k=0; k<9; k++)
-                if (v[i][j] & (1<<k))
-                    break;
-            std::cout << (char)('1'+k);
-            if (j%3 == 2)
-                std::cout << " ";
-        }
-        std::cout << std::endl;
-        if (i==8)
-            std::cout << "===========" << std::endl;
-        else if (i%3 == 2)
+    if (zout) {
+        uint8_t grid[81];
+        for (int i=0; i<81; i++)
+            grid[i] = __builtin_ctz(v[i/9][i%9]) + 1;
+        grid_write(*zout, grid);
+    } else {
+        for (int i=0; i<9; i++) {
+            for (int j=0; j<9; j++) {
+                int k;
+                for (k=0; k<9; k++)
+                    if (v[i][j] & (1<<k))
+                        break;
+                std::cout << (char)('1'+k);
+                if (j%3 == 2)
+                    std::cout << " ";
+            }
             std::cout << std::endl;
+            if (i==8)
+                std::cout << "===========" << std::endl;
+            else if (i%3 == 2)
+                std::cout << std::endl;
+        }
+        /*
+         * printed grids are only used as puzzle sources, a few per class
+         * do. the summary then has the count printed so far, -z gets all
+         */
+        if (solutions >= 200){
+            solutions++;
+            summary();
+            exit(0);
+        }
     }
 #endif
-    if (solutions >= 200){
-        exit(0);
-    }
     solutions++;
     if (solutions % (1<<20) == 0)
         /* progress indicator */
@@ -128,23 +284,66 @@ template<> static inline void search<8, 9>()
 }
 
 /*
- * fill everything except top left box, top row and left column.
- * we start by filling the first column, then first row, then
- * second column, then second row and so on.
+ * fill the free cells from the k-th of order O on. the purpose of using
+ * a template here is to profit from constant folding and from function
+ * inlining. S counts the nodes for -o, the plain search does not pay
+ * for that in its innermost loop.
  */
-template <int x, int y> static inline void search()
-{
-    int m = 0777 ^ mask(x, y);
-    while (m) {
-        int i = m & -m; // extract lowest 1-bit from m.
-        m -= i;
-        place(x, y, i);
-        search<(x>y ? x==3 && y<3 ? 8   : x-1 : y==8 ? 8   : x),
-               (x>y ? x==3 && y<3 ? y+1 : y   : y==8 ? x+1 : y+1)>();
-        undo(x, y, i);
+template <const cell_order &O, int k, bool S> static inline void search()
+{
+    if constexpr (k == FREE) {
+        found();
+    } else {
+        constexpr int x = O[k].x, y = O[k].y;
+        int m = 0777 ^ mask(x, y);
+        while (m) {
+            int i = m & -m; // extract lowest 1-bit from m.
+            m -= i;
+            if constexpr (S)
+                nodes++;
+            place(x, y, i);
+            search<O, k+1, S>();
+            undo(x, y, i);
+        }
     }
 }
 
+/* the built-in orders for -o, the first one is the default */
+static const struct
+{
+    const char *name;
+    const cell_order *order;
+    void (*search)();
+    /* the same, counting the nodes */
+    void (*counted)();
+} orders[] = {
+    {"columns-rows", &columns_rows, search<columns_rows, 0, false>,
+     search<columns_rows, 0, true>},
+    {"rows", &rows, search<rows, 0, false>, search<rows, 0, true>},
+    {"columns", &columns, search<columns, 0, false>,
+     search<columns, 0, true>},
+    {"boxes", &boxes, search<boxes, 0, false>, search<boxes, 0, true>},
+    {"constrained", &constrained, search<constrained, 0, false>,
+     search<constrained, 0, true>},
+};
+
+#ifdef PRINT
+/*
+ * cells (row*9+column) in the order they are filled: the first three
+ * rows, the first column and then the free cells in order o
+ */
+static void fill_order(const cell_order &o, uint8_t *order)
+{
+    int n = 0;
+    for (int i=0; i<27; i++)
+        order[n++] = i;
+    for (int i=3; i<9; i++)
+        order[n++] = i*9;
+    for (int k=0; k<FREE; k++)
+        order[n++] = o[k].x*9 + o[k].y;
+}
+#endif
+
 /*
  * table for remaining 6 entries of the first column with the following
  * constraints:
@@ -170,11 +369,79 @@ int main(int argc, char **argv)
 {
     /* choice for first column, -1 for 'all' */
     int choice_v = -1;
+    band_table table = {};
+    band_entry *entry = 0;
+    char mult_buf[16], config_buf[32];
+    /* fill order (index into orders[]), -o given, -z file */
+    int ord = 0;
+    bool stats = false;
+    const char *zfile = 0;
+#ifdef PRINT
+    grid_stream zs;
+#endif
     
     /* handle program args */
-    if (argc < 3) {
+    while (argc > 2 && (std::strcmp(argv[1], "-z") == 0 ||
+                        std::strcmp(argv[1], "-o") == 0)) {
+        if (argv[1][1] == 'z') {
+            zfile = argv[2];
+        } else {
+            int n = sizeof(orders)/sizeof(orders[0]);
+            for (ord=0; ord<n && std::strcmp(orders[ord].name, argv[2]); ord++)
+                ;
+            if (ord == n) {
+                std::cerr << "error: unknown order " << argv[2] << ", one of";
+                for (int k=0; k<n; k++)
+                    std::cerr << " " << orders[k].name;
+                std::cerr << std::endl;
+                return 1;
+            }
+            stats = true;
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    if (zfile) {
+#ifdef PRINT
+        uint8_t order[81];
+        fill_order(*orders[ord].order, order);
+        if (!grid_create(zs, zfile, order)) {
+            std::cerr << "error: can't create " << zfile << std::endl;
+            return 1;
+        }
+        zout = &zs;
+#else
+        std::cerr << "error: -z needs a PRINT build." << std::endl;
+        return 1;
+#endif
+    }
+    if (argc > 1 && std::strcmp(argv[1], "-t") == 0) {
+        if (argc < 4) {
+            std::cerr << "error: -t table id expected." << std::endl;
+            return 1;
+        }
+        if (!band_map(table, argv[2], true)) {
+            std::cerr << "error: can't map table " << argv[2] << std::endl;
+            return 1;
+        }
+        size_t id = atoi(argv[3]);
+        if (id >= table.header->count) {
+            std::cerr << "error: no configuration " << id << std::endl;
+            return 1;
+        }
+        entry = &table.entry[id];
+        std::sprintf(mult_buf, "%u", table.entry[entry->cls].eq_size);
+        std::sprintf(config_buf, "[%s]", entry->config);
+        mult = mult_buf;
+        config = config_buf;
+        argv += 2;
+        argc -= 2;
+    } else if (argc < 3) {
         std::cerr << "error: 2 or 3 arguments expected." << std::endl;
         return 1;
+    } else {
+        mult = argv[1];
+        config = argv[2];
     }
     if (argc > 3)
         choice_v = atoi(argv[3]);
@@ -183,7 +450,7 @@ int main(int argc, char **argv)
         for (int j=0; j<3; j++)
             place(i, j, 1<<(i*3+j));
     {
-        char *p = argv[2];
+        const char *p = config;
         for (int y=0; y<3; y++)
             for (int x=3; x<9; x++) {
                 while (*p && *p<'1' || *p>'9')
@@ -200,13 +467,22 @@ int main(int argc, char **argv)
     }
 
     /* actual search */
+    auto start = std::chrono::steady_clock::now();
     for (int v=0; v<10; v++) if (choice_v == -1 || v == choice_v) {
         for (int i=3; i<9; i++)
             place(i, 0, 1<<(rem[v][i-3]/3 + (rem[v][i-3]%3)*3));
-        search<8, 1>();
+        if (stats)
+            orders[ord].counted();
+        else
+            orders[ord].search();
         for (int i=3; i<9; i++)
             undo(i, 0, 1<<(rem[v][i-3]/3 + (rem[v][i-3]%3)*3));
     }
+    if (stats)
+        std::cerr << orders[ord].name << ": " << nodes << " nodes  "
+                  << std::chrono::duration<double>(std::chrono::steady_clock::now()
+                                                   - start).count()
+                  << " s" << std::endl;
 
 #if 0
     for (int i=0; i<3; i++)
@@ -220,6 +496,17 @@ int main(int argc, char **argv)
             std::exit(1);
         }
 #endif
-    std::cout << argv[2] << ": " << argv[1] << " * " << solutions << std::endl;
+#ifndef PRINT
+    /* PRINT stops after a few solutions, only complete counts are kept */
+    if (entry && choice_v == -1)
+        entry->completions = solutions;
+#endif
+    if (entry)
+        band_unmap(table);
+#ifdef PRINT
+    if (zout)
+        grid_close(zs);
+#endif
+    summary();
     return 0;
 }
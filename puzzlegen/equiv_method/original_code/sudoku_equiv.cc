@@ -19,6 +19,10 @@
 #include <iomanip>
 #include <cstdio>
 #include <cstring>
+#include <cstdlib>
+#include <atomic>
+#include <thread>
+#include "bandtable.h"
 
 /* repository of the 36288 normalized configurations */
 static std::map<std::string, size_t> rev_lookup;
@@ -142,6 +146,83 @@ bool box123::valid()
     return true;
 }
 
+/*
+ * add a configuration to the repository
+ */
+static void add_config(const std::string &s)
+{
+    rev_lookup[s] = lookup.size();
+    equiv.push_back(lookup.size());
+    eq_size.push_back(1);
+    lookup.push_back(s);
+}
+
+/*
+ * take the configurations from a table written by write_table()
+ * instead of generating them, and with classes set also their
+ * equivalence classes instead of deriving them
+ */
+static bool load_table(const char *path, bool classes)
+{
+    band_table t;
+    if (!band_map(t, path, false))
+        return false;
+    for (size_t i=0; i<t.header->count; i++) {
+        add_config(t.entry[i].config);
+        if (classes) {
+            equiv[i] = t.entry[i].cls;
+            eq_size[i] = t.entry[i].eq_size;
+        }
+    }
+    band_unmap(t);
+    return true;
+}
+
+static size_t lookup_eq(size_t i);
+
+/*
+ * write the configurations with their classes to a table. Completion
+ * counts already stored in an existing table of the same shape are
+ * carried over.
+ */
+static bool write_table(const char *path)
+{
+    band_header h;
+    std::memcpy(h.magic, BAND_MAGIC, 8);
+    h.version = BAND_VERSION;
+    h.count = lookup.size();
+
+    std::vector<band_entry> entries(lookup.size());
+    band_table old;
+    bool have_old = band_map(old, path, false);
+    if (have_old && old.header->count != h.count) {
+        band_unmap(old);
+        have_old = false;
+    }
+    for (size_t i=0; i<lookup.size(); i++) {
+        band_entry &e = entries[i];
+        /* the root, equiv[i] may be any node of the class */
+        size_t r = lookup_eq(i);
+        std::memset(e.config, 0, sizeof(e.config));
+        std::memcpy(e.config, lookup[i].data(), lookup[i].size());
+        e.cls = r;
+        e.eq_size = r == i ? eq_size[i] : 0;
+        e.completions = BAND_UNCOUNTED;
+        if (have_old && std::strcmp(old.entry[i].config, e.config) == 0)
+            e.completions = old.entry[i].completions;
+    }
+    if (have_old)
+        band_unmap(old);
+
+    std::FILE *f = std::fopen(path, "wb");
+    if (!f)
+        return false;
+    bool ok = std::fwrite(&h, sizeof(h), 1, f) == 1 &&
+        std::fwrite(&entries[0], sizeof(band_entry), entries.size(), f) ==
+        entries.size();
+    return std::fclose(f) == 0 && ok;
+}
+
 /*
  * generate the 36288 normalized configurations
  */
@@ -162,7 +243,6 @@ static void generate()
     };
     box123 b;
 
-    size_t id = 0;
     for (size_t h=0; h<10; h++) {
         for (size_t x=3; x<9; x++)
             b.val[0][x] = rem[h][x-3];
@@ -175,12 +255,7 @@ static void generate()
                 py++;
                 if (py == 3) {
                     /* found a configuration - store it */
-                    std::string s = b;
-                    rev_lookup[s] = id;
-                    lookup.push_back(s);
-                    equiv.push_back(id);
-                    eq_size.push_back(1);
-                    id++;
+                    add_config(b);
                     /* back to previous position */
                     py--;
                     px = 8;
@@ -261,13 +336,88 @@ static void add_eq(size_t i, size_t j, const char *descr)
     }
 }
 
+/*
+ * concurrent version of the relation for the parallel derivation.
+ *
+ * same inversed tree, but the parent pointers are atomic and a root
+ * is only ever linked below a root with a smaller index, using a
+ * compare and swap. Hence the roots end up being the same smallest
+ * configurations as in the serial version, whatever the order in
+ * which the threads merge their equivalences.
+ */
+static std::atomic<size_t> *cequiv;
+
+/*
+ * find the root for given node, halving the path on the way
+ */
+static size_t lookup_ceq(size_t i)
+{
+    for (;;) {
+        size_t p = cequiv[i].load(std::memory_order_relaxed);
+        if (p == i)
+            return i;
+        size_t gp = cequiv[p].load(std::memory_order_relaxed);
+        if (gp != p)
+            cequiv[i].compare_exchange_weak(p, gp, std::memory_order_relaxed);
+        i = gp;
+    }
+}
+
+/*
+ * merge the classes of two nodes; returns true if they were
+ * different before, i.e. if i-j is an edge of the forest.
+ */
+static bool add_ceq(size_t i, size_t j)
+{
+    for (;;) {
+        i = lookup_ceq(i);
+        j = lookup_ceq(j);
+        if (i == j)
+            return false;
+        if (i < j)
+            std::swap(i, j);
+        // i is the larger root now; it may have been linked meanwhile
+        size_t ei = i;
+        if (cequiv[i].compare_exchange_strong(ei, j, std::memory_order_relaxed))
+            return true;
+    }
+}
+
+/*
+ * where gen_eq sends its equivalences: straight into the relation,
+ * or, in parallel mode, into the concurrent relation, keeping the
+ * edges that joined two classes for the forest.
+ */
+struct serial_sink
+{
+    void add(size_t i, size_t j, const char *descr) {
+        add_eq(i, j, descr);
+    }
+};
+
+struct parallel_sink
+{
+    struct edge {
+        size_t i, j;
+        std::string descr;
+    };
+    std::vector<edge> edges;
+    void add(size_t i, size_t j, const char *descr) {
+        if (add_ceq(i, j)) {
+            edge e = { i, j, descr };
+            edges.push_back(e);
+        }
+    }
+};
+
 /*
  * like add_eq but one given node is a box configuration that
  * is normalized and looked up first.
  * Beware: the copying of the box123 object is intentional!
  * Don't use a reference here!
  */
-static void add_eq(size_t i, box123 j, const char *descr)
+template <class sink>
+static void add_eq(sink &out, size_t i, box123 j, const char *descr)
 {
 #ifdef DEBUG
     if (!j.valid()) {
@@ -282,7 +432,8 @@ static void add_eq(size_t i, box123 j, const char *descr)
                 return;
 #endif
     j.normalize();
-    add_eq(i, rev_lookup[j], descr);
+    // find() rather than operator[], several threads may be looking
+    out.add(i, rev_lookup.find(j)->second, descr);
 }
 
 /*
@@ -301,7 +452,8 @@ static void list_eq()
 /*
  * generate some 'atomic' equivalences of the box with id i.
  */
-static void gen_eq(size_t i)
+template <class sink>
+static void gen_eq(sink &out, size_t i)
 {
     box123 b(lookup[i]);
 
@@ -310,20 +462,20 @@ static void gen_eq(size_t i)
         // swap first rows.
         box123 b2 = b;
         b2.swap_row(0, 1);
-        add_eq(i, b2, "R(1,2)"); /* swap 0 1 */
+        add_eq(out, i, b2, "R(1,2)"); /* swap 0 1 */
         b2.swap_row(0, 1);
         b2.swap_row(0, 2);
-        add_eq(i, b2, "R(1,3)"); /* swap 0 2 */
+        add_eq(out, i, b2, "R(1,3)"); /* swap 0 2 */
     }
     // 6240 configurations here
     if (1) {
         // swap first box' columns
         box123 b2 = b;
         b2.swap_col(0, 1);
-        add_eq(i, b2, "C(1,2)"); /* swap 0 1 */
+        add_eq(out, i, b2, "C(1,2)"); /* swap 0 1 */
         b2.swap_col(0, 1);
         b2.swap_col(0, 2);
-        add_eq(i, b2, "C(1,3)"); /* swap 0 2 */
+        add_eq(out, i, b2, "C(1,3)"); /* swap 0 2 */
         // swapping columns in the other boxes would be undone by normalize()
     }
     // 1089 configurations here
@@ -331,10 +483,10 @@ static void gen_eq(size_t i)
         // swap boxes (idea due to AFJ)
         box123 b2 = b;
         b2.swap_box(0, 1);
-        add_eq(i, b2, "B(1,2)"); /* swap 0 1 */
+        add_eq(out, i, b2, "B(1,2)"); /* swap 0 1 */
         b2.swap_box(0, 1);
         b2.swap_box(0, 2);
-        add_eq(i, b2, "B(1,3)"); /* swap 0 2 */
+        add_eq(out, i, b2, "B(1,3)"); /* swap 0 2 */
     }
     // 416 configurations here
     if (1) {
@@ -354,7 +506,7 @@ static void gen_eq(size_t i)
                             std::sprintf(buf, "2x2(%d,%d/%d,%d)",
                                          x1+1, x2+1,
                                          y1+1, y2+1);
-                            add_eq(i, b2, buf);
+                            add_eq(out, i, b2, buf);
                         }
     }
     // 174 configurations here
@@ -370,7 +522,7 @@ static void gen_eq(size_t i)
                     char buf[64];
                     std::sprintf(buf, "2x3(%d,%d/1,2,3)",
                                  x1+1, x2+1);
-                    add_eq(i, b2, buf);
+                    add_eq(out, i, b2, buf);
                 }
     }
     // 141 configurations here
@@ -392,7 +544,7 @@ static void gen_eq(size_t i)
                                 std::sprintf(buf, "3x2(%d,%d,%d/%d,%d)",
                                              x1+1, x2+1, x3+1,
                                              y1+1, y2+1);
-                                add_eq(i, b2, buf);
+                                add_eq(out, i, b2, buf);
                             }
     }
     // 86 configurations here
@@ -421,7 +573,7 @@ static void gen_eq(size_t i)
                                     std::sprintf(buf, "4x2(%d,%d,%d,%d/%d,%d)",
                                                  x1+1, x2+1, x3+1, x4+1,
                                                  y1+1, y2+1);
-                                    add_eq(i, b2, buf);
+                                    add_eq(out, i, b2, buf);
                                 }
     }
     // 71 configurations here
@@ -445,13 +597,51 @@ static void gen_eq(size_t i)
                         for (int x=0; x<9; x++)
                             if (col & (1<<x))
                                 std::swap(b2.val[y1][x], b2.val[y2][x]);
-                        add_eq(i, b2, "???");
+                        add_eq(out, i, b2, "???");
                     }
         }
     }
     // 71 configurations here
 }
 
+/*
+ * derive the equivalences of all configurations with the given number
+ * of threads; thread t handles the configurations t, t+threads, ...
+ * Afterwards the relation, class sizes and forest are the same as
+ * (forest: equivalent to) those of the serial derivation.
+ */
+static void gen_eq_parallel(unsigned threads)
+{
+    size_t n = lookup.size();
+    cequiv = new std::atomic<size_t>[n];
+    for (size_t i=0; i<n; i++)
+        cequiv[i].store(i, std::memory_order_relaxed);
+
+    std::vector<parallel_sink> sinks(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t=0; t<threads; t++)
+        workers.push_back(std::thread([&sinks, t, threads, n]() {
+            for (size_t i=t; i<n; i+=threads)
+                gen_eq(sinks[t], i);
+        }));
+    for (unsigned t=0; t<threads; t++)
+        workers[t].join();
+
+    for (size_t i=0; i<n; i++) {
+        equiv[i] = lookup_ceq(i);
+        eq_size[i] = 0;
+    }
+    for (size_t i=0; i<n; i++)
+        eq_size[equiv[i]]++;
+    for (unsigned t=0; t<threads; t++)
+        for (size_t k=0; k<sinks[t].edges.size(); k++) {
+            const parallel_sink::edge &e = sinks[t].edges[k];
+            graph.insert(std::make_pair(e.i, std::make_pair(e.descr, e.j)));
+            graph.insert(std::make_pair(e.j, std::make_pair(e.descr+"'", e.i)));
+        }
+    delete[] cequiv;
+}
+
 /*
  * print a tree rooted at 'root'; don't visit 'prev' again.
  */
@@ -471,23 +661,58 @@ void print_tree(size_t root, int indent, const std::string &reason, size_t prev)
 int main(int argc, char **argv)
 {
     int forest = 0;
+    int threads = 0;
+    const char *table_in = 0;
+    const char *table_out = 0;
 
-    if (argc>1) {
-        if (std::strcmp(argv[1], "-f") == 0)
+    for (int k=1; k<argc; k++) {
+        if (std::strcmp(argv[k], "-f") == 0)
             forest = 1;
+        else if (std::strncmp(argv[k], "-j", 2) == 0) {
+            threads = std::atoi(argv[k]+2);
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 0)
+                threads = 1;
+        } else if (std::strcmp(argv[k], "-t") == 0 && k+1<argc)
+            table_in = argv[++k];
+        else if (std::strcmp(argv[k], "-w") == 0 && k+1<argc)
+            table_out = argv[++k];
         else {
             std::cout << "\
 Usage:\n\
-  " << argv[0] << " [-f]\n\
+  " << argv[0] << " [-f] [-j[n]] [-t table] [-w table]\n\
 -f ... print a forest of generating equivalences of the equivalence classes\n\
+-jn ... derive the equivalences with n threads (default: all cores)\n\
+-t table ... read the configurations and classes from a table instead of\n\
+             deriving them (with -f the classes are derived again)\n\
+-w table ... write the configurations and their classes to a table\n\
 no options ... print job list for actual calculation\n";
             return 0;
         }
     }
 
-    generate();
-    for (size_t i=0; i<lookup.size(); i++)
-        gen_eq(i);
+    /* the classes of a table are used as they are, only the forest
+       needs the equivalences derived again */
+    bool derive = !table_in || forest;
+    if (table_in) {
+        if (!load_table(table_in, !derive)) {
+            std::cerr << "error: can't read table " << table_in << std::endl;
+            return 1;
+        }
+    } else
+        generate();
+    if (derive && threads) {
+        gen_eq_parallel(threads);
+    } else if (derive) {
+        serial_sink out;
+        for (size_t i=0; i<lookup.size(); i++)
+            gen_eq(out, i);
+    }
+    if (table_out && !write_table(table_out)) {
+        std::cerr << "error: can't write table " << table_out << std::endl;
+        return 1;
+    }
     if (forest) {
         std::cout << "\
 #\n\
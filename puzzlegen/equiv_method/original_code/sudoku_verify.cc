@@ -0,0 +1,321 @@
+/*
+ * Verify the equivalence class forest for Sudoku grid calculation.
+ *
+ * C++ version of sudoku_verify.py: every rule of the forest written by
+ * "sudoku_equiv -f" is applied to the configuration of the parent, the
+ * result is canonized and compared with the child. Unlike the Python
+ * script it also checks that the forest is complete, i.e. that its
+ * nodes are 36288 different valid configurations in reduced form,
+ * which are all there are. The edges are checked on all cores.
+ *
+ * Usage:
+ * ./sudoku_equiv -f > tree
+ * ./sudoku_verify [-j4] [tree] > joblist
+ *
+ * Prints the verified job list like sudoku_verify.py, or the first
+ * error in the order of the file and exits with 1.
+ *
+ * Compile (example):
+ * g++ -O2 -pthread sudoku_verify.cc -o sudoku_verify
+ */
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <atomic>
+#include <thread>
+
+/* number of configurations of the first three boxes in reduced form */
+#define CONFIGS 36288
+
+/*
+ * a configuration in internal format: the three rows in order,
+ * 123abcdef 456ghijkl 789mnopqr for "[abcdef,ghijkl,mnopqr]"
+ */
+struct config
+{
+    int v[27];
+    bool operator==(const config &o) const {
+        return std::equal(v, v+27, o.v);
+    }
+    bool operator<(const config &o) const {
+        return std::lexicographical_compare(v, v+27, o.v, o.v+27);
+    }
+};
+
+static bool convert(const std::string &s, config &b)
+{
+    static const char *first = "123456789";
+    if (s.size() != 22 || s[0] != '[' || s[7] != ',' || s[14] != ',' || s[21] != ']')
+        return false;
+    for (int r=0; r<3; r++) {
+        for (int x=0; x<3; x++)
+            b.v[r*9+x] = first[r*3+x]-'0';
+        for (int x=0; x<6; x++) {
+            char c = s[1+r*7+x];
+            if (c < '1' || c > '9')
+                return false;
+            b.v[r*9+3+x] = c-'0';
+        }
+    }
+    return true;
+}
+
+/* basic building blocks, see sudoku_verify.py for when they are safe */
+static void swap_row(config &b, int r1, int r2, const int *xs, int n)
+{
+    for (int k=0; k<n; k++)
+        std::swap(b.v[r1*9+xs[k]], b.v[r2*9+xs[k]]);
+}
+
+static void swap_column(config &b, int c1, int c2)
+{
+    for (int y=0; y<3; y++)
+        std::swap(b.v[y*9+c1], b.v[y*9+c2]);
+}
+
+static void swap_box(config &b, int b1, int b2)
+{
+    for (int k=0; k<3; k++)
+        swap_column(b, b1*3+k, b2*3+k);
+}
+
+/* every row and box holds different entries */
+static bool valid(const config &b)
+{
+    for (int r=0; r<3; r++) {
+        int row = 0, box = 0;
+        for (int i=0; i<9; i++) {
+            row |= 1 << b.v[r*9+i];
+            box |= 1 << b.v[(i/3)*9 + r*3 + i%3];
+        }
+        if (row != 0x3fe || box != 0x3fe)
+            return false;
+    }
+    return true;
+}
+
+/* lexicographically reduce a configuration */
+static void canonize(config &b)
+{
+    int trans[10];
+    for (int i=0; i<9; i++)
+        trans[b.v[(i/3)*9+i%3]] = i+1;
+    for (int i=0; i<27; i++)
+        b.v[i] = trans[b.v[i]];
+    for (int k=3; k<9; k+=3) {
+        if (b.v[k] > b.v[k+1])
+            swap_column(b, k, k+1);
+        if (b.v[k+1] > b.v[k+2])
+            swap_column(b, k+1, k+2);
+        if (b.v[k] > b.v[k+1])
+            swap_column(b, k, k+1);
+    }
+    if (b.v[3] > b.v[6])
+        swap_box(b, 1, 2);
+}
+
+/*
+ * a node of the forest: its configuration, the rule relating it to
+ * its parent and the parent (-1 for roots)
+ */
+struct node
+{
+    std::string layout, rule;
+    config conf;
+    int parent;
+};
+
+/* read the numbers of a rule like "3x2(1,2,3/4,5)", 1-based */
+static int rule_args(const std::string &rule, int *a)
+{
+    int n = 0;
+    for (size_t k=rule.find('(')+1; k<rule.size(); k++)
+        if (rule[k] >= '1' && rule[k] <= '9')
+            a[n++] = rule[k]-'1';
+    return n;
+}
+
+/* check the edge to node i; returns an empty string or the error */
+static std::string check(const std::vector<node> &nodes, size_t i)
+{
+    const node &nd = nodes[i];
+    std::ostringstream err;
+    config b = nd.conf;
+    if (!valid(b) || !(canonize(b), b == nd.conf)) {
+        err << "Error: Invalid or unreduced configuration " << nd.layout;
+        return err.str();
+    }
+    if (nd.parent < 0)
+        return "";
+
+    const node &pa = nodes[nd.parent];
+    const std::string &rule = nd.rule;
+    config source = pa.conf, target = nd.conf;
+    if (rule[rule.size()-1] == '\'')
+        std::swap(source, target);
+
+    int a[8];
+    int n = rule.find('(') != std::string::npos ? rule_args(rule, a) : 0;
+    if (rule[0] == 'R' && n == 2 && rule[1] == '(') {
+        static const int all[9] = {0,1,2,3,4,5,6,7,8};
+        swap_row(source, a[0], a[1], all, 9);
+    } else if (rule[0] == 'C' && n == 2 && rule[1] == '(') {
+        swap_column(source, a[0], a[1]);
+    } else if (rule[0] == 'B' && n == 2 && rule[1] == '(') {
+        swap_box(source, a[0], a[1]);
+    } else if (rule.compare(0, 3, "2x2") == 0 && n == 4) {
+        swap_row(source, a[2], a[3], a, 2);
+    } else if (rule.compare(0, 3, "3x2") == 0 && n == 5) {
+        swap_row(source, a[3], a[4], a, 3);
+    } else if (rule.compare(0, 3, "4x2") == 0 && n == 6) {
+        swap_row(source, a[4], a[5], a, 4);
+    } else if (rule.compare(0, 3, "2x3") == 0 && n == 5) {
+        if (a[2] != 0 || a[3] != 1 || a[4] != 2) {
+            err << "Error: Unexpected application of 2x3 rule " << rule;
+            return err.str();
+        }
+        swap_column(source, a[0], a[1]);
+    } else {
+        err << "Error: Unknown rule " << rule;
+        return err.str();
+    }
+    if (!valid(source)) {
+        err << "Error after applying " << rule << ": invalid result";
+        return err.str();
+    }
+    canonize(source);
+    if (!(source == target)) {
+        err << "Error after applying " << nd.layout << " " << rule << " "
+            << pa.layout << ": mismatch";
+        return err.str();
+    }
+    return "";
+}
+
+int main(int argc, char **argv)
+{
+    const char *file = 0;
+    int threads = std::thread::hardware_concurrency();
+
+    for (int k=1; k<argc; k++) {
+        if (argv[k][0] == '-' && argv[k][1] == 'j')
+            threads = std::atoi(argv[k]+2);
+        else if (argv[k][0] != '-')
+            file = argv[k];
+        else {
+            std::cout << "Usage: " << argv[0] << " [-j4] [tree]\n";
+            return 1;
+        }
+    }
+    if (threads < 1)
+        threads = 1;
+
+    std::ifstream fin;
+    if (file) {
+        fin.open(file);
+        if (!fin) {
+            std::cout << "Error: can't open " << file << std::endl;
+            return 1;
+        }
+    }
+    std::istream &in = file ? fin : std::cin;
+
+    /* read the forest; stack holds the chain from the root to the
+       current node */
+    std::vector<node> nodes;
+    std::vector<int> stack;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+        size_t open = line.find('[');
+        size_t depth = open/2;
+        node nd;
+        if (open == std::string::npos || open%2 || depth > stack.size() ||
+            line.size() < open+25 || line[open+23] != '(' ||
+            line[line.size()-1] != ')' || !convert(line.substr(open, 22), nd.conf)) {
+            std::cout << "Error: Malformed line " << line << std::endl;
+            return 1;
+        }
+        nd.layout = line.substr(open, 22);
+        nd.rule = line.substr(open+24, line.size()-open-25);
+        if ((nd.rule == "ROOT") != (depth == 0)) {
+            std::cout << "Error: ROOT rule used on a non-root node "
+                "or a root without it: " << line << std::endl;
+            return 1;
+        }
+        stack.resize(depth);
+        nd.parent = depth ? stack.back() : -1;
+        stack.push_back(nodes.size());
+        nodes.push_back(nd);
+    }
+
+    /* check all edges, keeping the error of the first node that fails */
+    std::vector<std::string> errors(nodes.size());
+    std::atomic<size_t> next(0), first_error(nodes.size());
+    std::vector<std::thread> pool;
+    for (int t=0; t<threads; t++)
+        pool.push_back(std::thread([&]() {
+            for (;;) {
+                size_t lo = next.fetch_add(256);
+                if (lo >= nodes.size())
+                    break;
+                size_t hi = std::min(lo+256, nodes.size());
+                for (size_t i=lo; i<hi && i<first_error.load(); i++) {
+                    errors[i] = check(nodes, i);
+                    if (!errors[i].empty()) {
+                        size_t e = first_error.load();
+                        while (i < e && !first_error.compare_exchange_weak(e, i))
+                            ;
+                        break;
+                    }
+                }
+            }
+        }));
+    for (size_t t=0; t<pool.size(); t++)
+        pool[t].join();
+    if (first_error < nodes.size()) {
+        std::cout << errors[first_error] << std::endl;
+        return 1;
+    }
+
+    /* complete: CONFIGS different valid reduced configurations */
+    std::vector<config> all;
+    for (size_t i=0; i<nodes.size(); i++)
+        all.push_back(nodes[i].conf);
+    std::sort(all.begin(), all.end());
+    for (size_t i=1; i<all.size(); i++)
+        if (all[i] == all[i-1]) {
+            for (size_t j=0; j<nodes.size(); j++)
+                if (nodes[j].conf == all[i]) {
+                    std::cout << "Error: Duplicate configuration " << nodes[j].layout
+                              << std::endl;
+                    break;
+                }
+            return 1;
+        }
+    if (all.size() != CONFIGS) {
+        std::cout << "Error: " << all.size() << " configurations instead of "
+                  << CONFIGS << std::endl;
+        return 1;
+    }
+
+    std::cout << "# verified job list created by sudoku_verify" << std::endl;
+    for (size_t i=0; i<nodes.size(); ) {
+        size_t j = i+1;
+        while (j < nodes.size() && nodes[j].parent >= 0)
+            j++;
+        char buf[64];
+        std::snprintf(buf, sizeof(buf), "./sudoku2%6d  ", (int)(j-i));
+        std::cout << buf << nodes[i].layout << '\n';
+        i = j;
+    }
+    return 0;
+}
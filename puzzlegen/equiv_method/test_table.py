@@ -0,0 +1,36 @@
+import os
+import struct
+import subprocess
+import sys
+import tempfile
+
+# Check that equiv writes the same band table serially and with -j, and
+# that every entry points at a class representative.
+#   g++ -O2 -pthread original_code/sudoku_equiv.cc -o equiv
+#   python3 test_table.py [binary]
+
+HEADER = struct.Struct("8sII")
+ENTRY = struct.Struct("24sIIQ")
+
+binary = os.path.abspath(sys.argv[1] if len(sys.argv) > 1 else "./equiv")
+
+with tempfile.TemporaryDirectory() as tmp:
+    serial = os.path.join(tmp, "serial.tbl")
+    parallel = os.path.join(tmp, "parallel.tbl")
+    subprocess.run([binary, "-w", serial], stdout=subprocess.DEVNULL, check=True)
+    subprocess.run([binary, "-j4", "-w", parallel], stdout=subprocess.DEVNULL, check=True)
+    with open(serial, "rb") as f:
+        table = f.read()
+    with open(parallel, "rb") as f:
+        if f.read() != table:
+            sys.exit("error: the serial and the -j4 table differ")
+
+_, _, count = HEADER.unpack_from(table, 0)
+entries = [ENTRY.unpack_from(table, HEADER.size + i * ENTRY.size) for i in range(count)]
+for i, (config, cls, eq_size, _) in enumerate(entries):
+    if entries[cls][1] != cls or not entries[cls][2] or (eq_size != 0) != (cls == i):
+        name = config.rstrip(b"\0").decode()
+        sys.exit(f"error: entry {i} [{name}] has class {cls}, which is not a representative")
+if sum(entry[2] for entry in entries) != count:
+    sys.exit("error: the class sizes do not add up to the configurations")
+print(f"ok: {count} configurations in {sum(1 for entry in entries if entry[2])} classes")
@@ -0,0 +1,183 @@
+/*
+ * Count the solutions of Sudoku variants with the exact cover engine
+ * of exactcover.h.
+ *
+ * The variant is a combination of the flags below on top of the
+ * standard rules; each combination is a separate instantiation of
+ * ec::exact_cover, so plain Sudoku runs on the fixed-width matrix.
+ *
+ * Usage:
+ * ./ecsolve [-n3] [-x] [-w] [-k] [-g regions] [-s999] [-v4000000] [-p] file
+ *
+ * Compile (example):
+ * g++ -std=c++17 -O3 -march=native ecsolve.cc -o ecsolve
+ */
+
+#include <vector>
+#include <string>
+#include <iostream>
+#include <fstream>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include "exactcover.h"
+
+static const char L[] = ".123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz#*~";
+
+struct options
+{
+    int n = 3;
+    bool x = false, w = false, k = false, print = false;
+    const char *regions = 0, *file = 0;
+    long long limit = 999, max_nodes = 4000000;
+    std::vector<int> region;
+};
+
+/* parse up to cells values from a line; empty cells are . - * or 0 */
+static bool parse(const std::string &line, int n2, std::vector<int> &p)
+{
+    size_t i = 0;
+    for (size_t k=0; k<line.size() && i<p.size(); k++) {
+        char c = line[k];
+        if (c == '.' || c == '-' || c == '*' || c == '0') {
+            p[i++] = 0;
+            continue;
+        }
+        const char *q = std::strchr(L+1, c);
+        if (q && c && q-L <= n2)
+            p[i++] = q-L;
+    }
+    return i == p.size();
+}
+
+template <class Cover>
+static int run(Cover &ec, const options &o)
+{
+    const ec::geometry &g = ec.geom();
+    std::ifstream in(o.file);
+    if (!in) {
+        std::cerr << "error: can't open " << o.file << std::endl;
+        return 1;
+    }
+    std::vector<int> p(g.cells), sol(g.cells);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!parse(line, g.n2, p))
+            continue;
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        ec::result res = ec.count(&p[0], o.limit, o.max_nodes, &sol[0]);
+        double ms = std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now() - t0).count();
+        if (o.print && res.count) {
+            for (int i=0; i<g.cells; i++)
+                std::cout << L[sol[i]];
+            std::cout << '\n';
+            continue;
+        }
+        if (!res.complete)
+            std::cout << "incomplete(nodes) ";
+        else if (res.count >= o.limit)
+            std::cout << "incomplete(solutions) ";
+        std::printf("%lld sol.  %lld nodes  %.3f ms\n", res.count, res.nodes, ms);
+        std::fflush(stdout);
+    }
+    return 0;
+}
+
+/*
+ * add the optional sets one flag at a time, so every combination gets
+ * its own instantiation
+ */
+template <class... Sets>
+static int with_k(const options &o, Sets... s)
+{
+    if (o.k) {
+        ec::exact_cover<Sets..., ec::antiking_set> c(o.n, s..., ec::antiking_set());
+        return run(c, o);
+    }
+    ec::exact_cover<Sets...> c(o.n, s...);
+    return run(c, o);
+}
+
+template <class... Sets>
+static int with_w(const options &o, Sets... s)
+{
+    return o.w ? with_k(o, s..., ec::window_set()) : with_k(o, s...);
+}
+
+template <class... Sets>
+static int with_x(const options &o, Sets... s)
+{
+    return o.x ? with_w(o, s..., ec::diag_set()) : with_w(o, s...);
+}
+
+/* regions file: n2*n2 symbols 1..n2 giving the region of each cell */
+static bool read_regions(options &o)
+{
+    int n2 = o.n*o.n;
+    std::ifstream in(o.regions);
+    std::string all, line;
+    while (std::getline(in, line))
+        all += line;
+    std::vector<int> p(n2*n2);
+    if (!parse(all, n2, p))
+        return false;
+    std::vector<int> size(n2, 0);
+    for (size_t i=0; i<p.size(); i++) {
+        if (!p[i] || ++size[p[i]-1] > n2)
+            return false;
+        o.region.push_back(p[i]-1);
+    }
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    options o;
+
+    for (int k=1; k<argc; k++) {
+        if (argv[k][0] != '-')
+            o.file = argv[k];
+        else if (argv[k][1] == 'n')
+            o.n = std::atoi(argv[k]+2);
+        else if (argv[k][1] == 'x')
+            o.x = true;
+        else if (argv[k][1] == 'w')
+            o.w = true;
+        else if (argv[k][1] == 'k')
+            o.k = true;
+        else if (argv[k][1] == 'p')
+            o.print = true;
+        else if (argv[k][1] == 's')
+            o.limit = std::atoll(argv[k]+2);
+        else if (argv[k][1] == 'v')
+            o.max_nodes = std::atoll(argv[k]+2);
+        else if (argv[k][1] == 'g' && k+1 < argc)
+            o.regions = argv[++k];
+    }
+    if (!o.file || o.n < 2 || o.n > 8) {
+        std::cout << "\
+Usage:\n\
+  " << argv[0] << " [-n3] [-x] [-w] [-k] [-g regions] [-s999] [-v4000000] [-p] file\n\
+counts the solutions of the puzzles in file, one per line\n\
+-n3 ... box size, 3 for 9x9 (default)\n\
+-x ... both long diagonals hold every value once (X-Sudoku)\n\
+-w ... windoku, the (n-1)^2 inner windows hold every value once\n\
+-k ... anti-king, diagonally touching cells differ\n\
+-g file ... jigsaw, file gives the region 1..n*n of every cell instead of boxes\n\
+-s999 ... stop counting at 999 solutions\n\
+-v4000000 ... stop after 4000000 nodes, 0 for no limit\n\
+-p ... print the first solution instead of the count\n";
+        return 1;
+    }
+    if (o.regions) {
+        if (!read_regions(o)) {
+            std::cerr << "error: bad regions file " << o.regions << std::endl;
+            return 1;
+        }
+        return with_x(o, ec::cell_set(), ec::row_set(), ec::col_set(),
+                      ec::region_set(o.region));
+    }
+    return with_x(o, ec::cell_set(), ec::row_set(), ec::col_set(), ec::box_set());
+}
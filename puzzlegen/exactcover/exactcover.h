@@ -0,0 +1,464 @@
+/*
+ * Exact cover engine for Sudoku and its variants.
+ *
+ * The rows of the matrix are the candidates (cell, value); the columns
+ * come from a list of constraint sets given as template arguments, e.g.
+ * exact_cover<cell_set, row_set, col_set, box_set> is plain Sudoku.
+ * Columns of a primary set must be covered exactly once, columns of a
+ * secondary set (optional<S>, antiking_set) at most once.
+ *
+ * The matrix is kept as flat arrays: the columns of all rows in one
+ * vector and the rows of all columns in another, with offsets. If every
+ * set adds the same number of columns to each candidate the row width
+ * is a compile time constant and the row offsets are dropped, which is
+ * the case for Sudoku, jigsaw and other combinations of one column per
+ * candidate. The search is the one of suexk.c: counters for covered
+ * columns, blocked rows and live rows per column instead of dancing
+ * links, the column with the fewest live rows first, and a column
+ * that drops to one live row is taken next without a scan.
+ *
+ * A constraint set provides
+ *   static constexpr int width;     columns per candidate, -1 if it varies
+ *   static constexpr bool primary;
+ *   int columns(const geometry &) const;
+ *   template <class F> void emit(const geometry &, int cell, int val, F &) const;
+ * where emit calls f(k) with the set's column 0 <= k < columns() for each
+ * column the candidate lies in.
+ */
+
+#ifndef EXACTCOVER_H
+#define EXACTCOVER_H
+
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <cstddef>
+#include <stdint.h>
+
+namespace ec {
+
+/*
+ * a board of n*n boxes of n*n cells; cell = y*n2 + x, values 0..n2-1
+ */
+struct geometry
+{
+    int n, n2, cells;
+    explicit geometry(int n) : n(n), n2(n*n), cells(n*n*n*n) {}
+    int x(int cell) const { return cell % n2; }
+    int y(int cell) const { return cell / n2; }
+    int box(int cell) const { return y(cell)/n*n + x(cell)/n; }
+};
+
+/* every cell holds one value */
+struct cell_set
+{
+    static constexpr int width = 1;
+    static constexpr bool primary = true;
+    int columns(const geometry &g) const { return g.cells; }
+    template <class F> void emit(const geometry &, int cell, int, F &f) const {
+        f(cell);
+    }
+};
+
+/* every value once per row */
+struct row_set
+{
+    static constexpr int width = 1;
+    static constexpr bool primary = true;
+    int columns(const geometry &g) const { return g.cells; }
+    template <class F> void emit(const geometry &g, int cell, int val, F &f) const {
+        f(g.y(cell)*g.n2 + val);
+    }
+};
+
+/* every value once per column */
+struct col_set
+{
+    static constexpr int width = 1;
+    static constexpr bool primary = true;
+    int columns(const geometry &g) const { return g.cells; }
+    template <class F> void emit(const geometry &g, int cell, int val, F &f) const {
+        f(g.x(cell)*g.n2 + val);
+    }
+};
+
+/* every value once per box */
+struct box_set
+{
+    static constexpr int width = 1;
+    static constexpr bool primary = true;
+    int columns(const geometry &g) const { return g.cells; }
+    template <class F> void emit(const geometry &g, int cell, int val, F &f) const {
+        f(g.box(cell)*g.n2 + val);
+    }
+};
+
+/* every value once per irregular region (jigsaw); region[cell] is 0..n2-1 */
+struct region_set
+{
+    static constexpr int width = 1;
+    static constexpr bool primary = true;
+    std::vector<int> region;
+    explicit region_set(const std::vector<int> &r) : region(r) {}
+    int columns(const geometry &g) const { return g.cells; }
+    template <class F> void emit(const geometry &g, int cell, int val, F &f) const {
+        f(region[cell]*g.n2 + val);
+    }
+};
+
+/* every value once on each of the two long diagonals (X-Sudoku) */
+struct diag_set
+{
+    static constexpr int width = -1;
+    static constexpr bool primary = true;
+    int columns(const geometry &g) const { return 2*g.n2; }
+    template <class F> void emit(const geometry &g, int cell, int val, F &f) const {
+        if (g.x(cell) == g.y(cell))
+            f(val);
+        if (g.x(cell) + g.y(cell) == g.n2-1)
+            f(g.n2 + val);
+    }
+};
+
+/*
+ * every value once in each of the (n-1)^2 extra windows of windoku,
+ * the boxes shifted by one cell away from the border, so for 9x9 the
+ * windows start at rows and columns 1 and 5
+ */
+struct window_set
+{
+    static constexpr int width = -1;
+    static constexpr bool primary = true;
+    int columns(const geometry &g) const { return (g.n-1)*(g.n-1)*g.n2; }
+    template <class F> void emit(const geometry &g, int cell, int val, F &f) const {
+        int wx = g.x(cell) - 1, wy = g.y(cell) - 1;
+        if (wx < 0 || wy < 0 || wx % (g.n+1) == g.n || wy % (g.n+1) == g.n)
+            return;
+        wx /= g.n+1;
+        wy /= g.n+1;
+        if (wx < g.n-1 && wy < g.n-1)
+            f((wy*(g.n-1) + wx)*g.n2 + val);
+    }
+};
+
+/*
+ * no value twice in diagonally touching cells (anti-king; orthogonal
+ * neighbours are already covered by rows and columns). One secondary
+ * column per touching pair and value; pair p of cell y*n2+x is to
+ * (x+1,y+1) for p = 0 and to (x-1,y+1) for p = 1
+ */
+struct antiking_set
+{
+    static constexpr int width = -1;
+    static constexpr bool primary = false;
+    int columns(const geometry &g) const { return 2*g.cells*g.n2; }
+    template <class F> void emit(const geometry &g, int cell, int val, F &f) const {
+        int x = g.x(cell), y = g.y(cell);
+        if (x+1 < g.n2 && y+1 < g.n2)
+            f((2*cell)*g.n2 + val);
+        if (x > 0 && y+1 < g.n2)
+            f((2*cell+1)*g.n2 + val);
+        if (x > 0 && y > 0)
+            f((2*(cell-g.n2-1))*g.n2 + val);
+        if (x+1 < g.n2 && y > 0)
+            f((2*(cell-g.n2+1)+1)*g.n2 + val);
+    }
+};
+
+/* turns the columns of a primary set into secondary ones */
+template <class S>
+struct optional : S
+{
+    static constexpr bool primary = false;
+    using S::S;
+    optional() {}
+    optional(const S &s) : S(s) {}
+};
+
+/*
+ * outcome of a count; complete is false if the node limit stopped
+ * the search, count is then a lower bound. guesses counts the nodes
+ * where no column was down to one row
+ */
+struct result
+{
+    long long count, nodes, guesses;
+    bool complete;
+};
+
+template <class... Sets>
+class exact_cover
+{
+public:
+    /* columns per row if fixed for all sets, 0 otherwise */
+    static constexpr int W = ((Sets::width >= 0) && ...) ? (0 + ... + Sets::width) : 0;
+
+    exact_cover(int n, Sets... s) : g(n), sets(s...) { build(); }
+
+    const geometry &geom() const { return g; }
+    int rows() const { return nrows; }
+    int columns() const { return ncols; }
+
+    /*
+     * count the solutions of the puzzle (value+1 per cell, 0 if empty)
+     * up to limit, stopping after max_nodes nodes if that is > 0. The
+     * first solution found is stored in first and the last one in last
+     * if given, so with limit 2 they are two different solutions.
+     */
+    result count(const int *puzzle, long long limit, long long max_nodes = 0,
+                 int *first = 0, int *last = 0)
+    {
+        result res = {0, 0, 0, true};
+        for (int r=0; r<nrows; r++)
+            ur[r] = 0;
+        for (int c=0; c<ncols; c++)
+            uc[c] = 0;
+        open = nprim;
+        for (int i=0; i<g.cells; i++) {
+            if (!puzzle[i])
+                continue;
+            int r = i*g.n2 + puzzle[i]-1;
+            const int32_t *rc = row_cols(r);
+            for (int j=0, w=row_width(r); j<w; j++) {
+                int c = rc[j];
+                if (uc[c]++)
+                    return res;
+                if (c < nprim)
+                    open--;
+                for (int k=col_begin[c]; k<col_begin[c+1]; k++)
+                    ur[col_row[k]]++;
+            }
+        }
+        for (int c=0; c<ncols; c++) {
+            v[c] = 0;
+            for (int k=col_begin[c]; k<col_begin[c+1]; k++)
+                if (!ur[col_row[k]])
+                    v[c]++;
+        }
+
+        int depth = 0, c = -1;
+        dead = false;
+        forced = -1;
+        for (;;) {
+            /* choose a column for this depth */
+            if (dead)
+                goto back;
+            if (!open) {
+                if (!res.count++ && first)
+                    solution(puzzle, depth, first);
+                if (last)
+                    solution(puzzle, depth, last);
+                if (res.count >= limit)
+                    break;
+                goto back;
+            }
+            if (forced >= 0) {
+                c = forced;
+            } else {
+                int min = nrows+1;
+                for (int c1=0; c1<nprim; c1++)
+                    if (!uc[c1] && v[c1] < min) {
+                        min = v[c1];
+                        c = c1;
+                        if (min < 2)
+                            break;
+                    }
+                if (!min)
+                    goto back;
+                if (min > 1)
+                    res.guesses++;
+            }
+            stack_col[depth] = c;
+            stack_pos[depth] = col_begin[c];
+
+        next:
+            /* try the next live row of the column at this depth */
+            {
+                c = stack_col[depth];
+                int k = stack_pos[depth];
+                while (k < col_begin[c+1] && ur[col_row[k]])
+                    k++;
+                if (k == col_begin[c+1])
+                    goto back;
+                stack_pos[depth] = k+1;
+                stack_row[depth] = col_row[k];
+                dead = false;
+                forced = -1;
+                cover(col_row[k]);
+                depth++;
+                if (++res.nodes == max_nodes) {
+                    res.complete = false;
+                    break;
+                }
+                continue;
+            }
+
+        back:
+            if (!depth)
+                break;
+            depth--;
+            uncover(stack_row[depth]);
+            goto next;
+        }
+        return res;
+    }
+
+private:
+    geometry g;
+    std::tuple<Sets...> sets;
+    int nrows, ncols, nprim;
+
+    /* matrix: columns of row r at row_col[r*W] (or row_begin[r] if W == 0),
+       rows of column c at col_row[col_begin[c]..col_begin[c+1]) */
+    std::vector<int32_t> row_col, row_begin, col_row, col_begin;
+
+    /* search state: covers of each column, blocking rows of each row,
+       live rows of each column, and the stack */
+    std::vector<int32_t> uc, ur, v, stack_col, stack_pos, stack_row;
+    int open, forced;
+    bool dead;
+
+    const int32_t *row_cols(int r) const {
+        if constexpr (W > 0)
+            return &row_col[r*W];
+        else
+            return &row_col[row_begin[r]];
+    }
+    int row_width(int r) const {
+        if constexpr (W > 0)
+            return W;
+        else
+            return row_begin[r+1] - row_begin[r];
+    }
+
+    /* the clues and the rows on the stack as a solution */
+    void solution(const int *puzzle, int depth, int *sol) const
+    {
+        for (int i=0; i<g.cells; i++)
+            sol[i] = puzzle[i];
+        for (int d=0; d<depth; d++)
+            sol[stack_row[d]/g.n2] = stack_row[d]%g.n2 + 1;
+    }
+
+    void cover(int r)
+    {
+        const int32_t *rc = row_cols(r);
+        int w = row_width(r);
+        for (int j=0; j<w; j++)
+            if (!uc[rc[j]]++ && rc[j] < nprim)
+                open--;
+        for (int j=0; j<w; j++) {
+            int c = rc[j];
+            for (int k=col_begin[c]; k<col_begin[c+1]; k++) {
+                int r1 = col_row[k];
+                if (ur[r1]++)
+                    continue;
+                const int32_t *rc1 = row_cols(r1);
+                for (int l=0, w1=row_width(r1); l<w1; l++) {
+                    int c2 = rc1[l];
+                    if (--v[c2] < 2 && c2 < nprim && !uc[c2]) {
+                        if (v[c2])
+                            forced = c2;
+                        else
+                            dead = true;
+                    }
+                }
+            }
+        }
+    }
+
+    void uncover(int r)
+    {
+        const int32_t *rc = row_cols(r);
+        int w = row_width(r);
+        for (int j=0; j<w; j++) {
+            int c = rc[j];
+            if (!--uc[c] && c < nprim)
+                open++;
+            for (int k=col_begin[c]; k<col_begin[c+1]; k++) {
+                int r1 = col_row[k];
+                if (--ur[r1])
+                    continue;
+                const int32_t *rc1 = row_cols(r1);
+                for (int l=0, w1=row_width(r1); l<w1; l++)
+                    v[rc1[l]]++;
+            }
+        }
+    }
+
+    /* number the columns of the primary sets first */
+    template <size_t... I>
+    void bases(int *base, std::index_sequence<I...>)
+    {
+        int next = 0;
+        ((std::tuple_element_t<I, std::tuple<Sets...> >::primary ?
+          (base[I] = next, next += std::get<I>(sets).columns(g)) : 0), ...);
+        nprim = next;
+        ((!std::tuple_element_t<I, std::tuple<Sets...> >::primary ?
+          (base[I] = next, next += std::get<I>(sets).columns(g)) : 0), ...);
+        ncols = next;
+    }
+
+    void build()
+    {
+        std::index_sequence_for<Sets...> seq;
+        int base[sizeof...(Sets)+1];
+        bases(base, seq);
+        nrows = g.cells*g.n2;
+
+        /* columns of each row */
+        row_begin.assign(1, 0);
+        for (int cell=0; cell<g.cells; cell++)
+            for (int val=0; val<g.n2; val++) {
+                add_row(base, cell, val, seq);
+                if constexpr (W == 0)
+                    row_begin.push_back(row_col.size());
+            }
+        if constexpr (W > 0)
+            row_begin.clear();
+
+        /* rows of each column */
+        col_begin.assign(ncols+1, 0);
+        for (int r=0; r<nrows; r++)
+            for (int j=0; j<row_width(r); j++)
+                col_begin[row_cols(r)[j]+1]++;
+        for (int c=0; c<ncols; c++)
+            col_begin[c+1] += col_begin[c];
+        col_row.resize(col_begin[ncols]);
+        std::vector<int32_t> fill(col_begin.begin(), col_begin.end()-1);
+        for (int r=0; r<nrows; r++)
+            for (int j=0; j<row_width(r); j++)
+                col_row[fill[row_cols(r)[j]]++] = r;
+
+        uc.resize(ncols);
+        v.resize(ncols);
+        ur.resize(nrows);
+        stack_col.resize(nrows+1);
+        stack_pos.resize(nrows+1);
+        stack_row.resize(nrows+1);
+    }
+
+    template <size_t... I>
+    void add_row(const int *base, int cell, int val, std::index_sequence<I...>)
+    {
+        (add_cols<I>(base[I], cell, val), ...);
+    }
+
+    template <size_t I>
+    void add_cols(int base, int cell, int val)
+    {
+        auto f = [&](int k) { row_col.push_back(base + k); };
+        std::get<I>(sets).emit(g, cell, val, f);
+    }
+};
+
+/* the common variants */
+typedef exact_cover<cell_set, row_set, col_set, box_set> sudoku;
+typedef exact_cover<cell_set, row_set, col_set, box_set, diag_set> x_sudoku;
+typedef exact_cover<cell_set, row_set, col_set, region_set> jigsaw;
+typedef exact_cover<cell_set, row_set, col_set, box_set, window_set> windoku;
+typedef exact_cover<cell_set, row_set, col_set, box_set, antiking_set> antiking;
+
+}
+
+#endif
@@ -2,6 +2,8 @@
 //  source http://magictour.free.fr/sudoku.htm
 #include <stdlib.h>
 #include <stdio.h>
+#include <signal.h>
+#include <time.h>
 #define N 3
 #define N2 N*N
 #define N4 N2*N2
@@ -12,22 +14,92 @@ int Rows[4*N4+9],Cols[N2*N4+9],Row[4*N4+9][N2+1],Col[N2*N4+9][5];
 int Ur[N2*N4+9],Uc[4*N4+9],V[4*N4+9];
 int P[N4+9],A[N4+9],C[N4+9],I[N4+9],S[N4+9];
 int sd,smax,s1,m0,c1,c2,r1,l,i1,m1,m2,a,p,i,j,k,r,c,d,n=N2*N4,m=4*N4,x,y,s;
-int nodes,seed,solutions,min,clues;
+int nodes,seed,solutions,min,clues,u,tried,clues0,o,t;
 char L[17]=".123456789ABCDEFG";
+
+/* what the checks of one grid found, for the later checks of any removal
+   order and restart: a witness of a clue set that is not unique differs
+   from Sol on an unavoidable set, which goes into the bank below, and the
+   clues a restart ends with are a unique set, kept in Kq (nq of them), so
+   a clue set that contains one of them is unique */
+#define QS 64
+unsigned long long Kq[QS][2];int nq;long long cprobes,chits;
+int A0[N4+9],Sol[N4+9],Ws[2][N4+9],restarts,rs;
+
+/* bank of small unavoidable sets of the solution grid, from its
+   rectangles and from the witnesses of the checks. U[s] holds the
+   cells of set s (cell i is bit i-1), H[i] the sets containing cell i
+   and K the current clues. removing clue i breaks uniqueness if a set in
+   H[i] has no other clue, which decides most rejections without calling
+   the solver. once full, a new set replaces the oldest one in the last
+   quarter, or after the sets of the grid if they leave more room */
+#define US 256
+unsigned long long U[US][2],H[N4+9][US/64],K[2];
+int us,uw,uw0;long long utries,uhits;
+/* limits of one input sudoku: a deadline of dl ms wall clock and vmax
+   search nodes over all its solves, and SIGINT/SIGTERM. solve() checks
+   them on every node (the clock every 1024 nodes) and returns -2 when
+   stopped. the removal loop then keeps the clue it was testing, so the
+   sudoku printed is still unique but may not be minimal; it is marked
+   "incomplete(why)" with the clues tried and the nodes used. after a
+   signal the program exits with 2 */
+volatile sig_atomic_t stop;long long dl,dl0,vmax,pnodes;char *why;
+/* orbits of the cells under the symmetry of option y: the removal loop
+   takes out the clues of a whole orbit at once, so the puzzles come out
+   symmetric and need one check per orbit. without y every cell is its
+   own orbit. Ob[o] holds the On[o] cells of orbit o, no is the count */
+int Ob[N4+9][4],On[N4+9],no,sym;
+/* the uncovered columns of solve() by their number of live rows: bit c of
+   B[v] is set if column c is uncovered and V[c]==v, Bn[v] counts them.
+   kept up to date wherever Uc or V changes, so the column to branch on
+   is found without scanning all m columns */
+#define BW (4*N4/64+1)
+unsigned long long B[N2+2][BW];int Bn[N2+2];
+#define BIN(c) (B[V[c]][(c)>>6]|=1ULL<<((c)&63),Bn[V[c]]++)
+#define BOUT(c) (B[V[c]][(c)>>6]^=1ULL<<((c)&63),Bn[V[c]]--)
+#define BDEC(c) (BOUT(c),V[c]--,BIN(c))
+#define BINC(c) (BOUT(c),V[c]++,BIN(c))
+/* the removal loop only asks if a solution other than Sol exists. with
+   at most HMAX holes other() searches the holes directly on bit masks
+   of the values in each row, column and box (Mr, Mc, Mb), with the
+   holes in Ho; with more it runs solve() with dif set, which takes the
+   row of Sol in each column last (Q[c] is its index in Row[c]) and
+   stops at the first solution different from Sol. both try the values
+   that differ from Sol first */
+#define HMAX 48
+int Q[4*N4+9],R[N4+9],Ho[N4+9],Mr[N2],Mc[N2],Mb[N2],dif;
 FILE *file;
 int solve(int);
+int halted();
+long long msec();
+void cancel(int);
+int tsolve();
+int other();
+int holes(int,int);
+void unavoidable();
+int uforced(int);
+void uadd(unsigned long long,unsigned long long);
+int symmap(int);
 void print_board();
 void print_cdf();
 
 
 int main(int argc,char*argv[]){
-  if(argc<2){printf("\nusage:suex9- file [seed] \n\n    deletes non-necessary clues from the sudokus in file\n\n");
+  if(argc<2){printf("\nusage:suex9- file [seed] [restarts] [ms] [nodes] [y2|y4|yd|ym] \n\n    deletes non-necessary clues from the sudokus in file\n\n");
       printf("so it generates minimal sudokus with the same solution\n");
       printf("specify seed, if you want different streams of minimal sudokus (default:seed=0)\n");
       printf("puzzles in file without unique solution are ignored\n\n");
       printf("if seed<0 then the sudokus are printed in long, human-readable format\n\n");
+      printf("restarts>1 minimizes each sudoku that many times in different random orders\n\n");
+      printf("ms>0 stops a sudoku after ms milliseconds, nodes>0 after that many search nodes\n\n");
+      printf("y2,y4,yd,ym keep the clues symmetric under 180 or 90 degree rotation,\n");
+      printf("the main diagonal or the left-right mirror (anywhere after file)\n\n");
       exit(1);}
-  seed=0;if(argc>2)sscanf(argv[2],"%i",&seed);
+  seed=0;restarts=1;dl=0;vmax=0;sym=0;
+  for(k=2,x=0;k<argc;k++){if(argv[k][0]=='y'){sym=argv[k][1];continue;}
+    x++;if(x==1)sscanf(argv[k],"%i",&seed);if(x==2)sscanf(argv[k],"%i",&restarts);
+    if(x==3)sscanf(argv[k],"%lld",&dl);if(x==4)sscanf(argv[k],"%lld",&vmax);}
+  signal(SIGINT,cancel);signal(SIGTERM,cancel);
     sd=0;if(seed<0){sd=1;seed=-seed;}zr^=seed;wr+=seed;
 
 k=N;r=0;for(x=1;x<=N2;x++)for(y=1;y<=N2;y++)for(s=1;s<=N2;s++){
@@ -36,29 +108,180 @@ Col[r][3]=x*N2-N2+s+N4*2;Col[r][4]=y*N2-N2+s+N4*3;}
 for(c=1;c<=m;c++)Rows[c]=0;
 for(r=1;r<=n;r++)for(c=1;c<=Cols[r];c++){
 a=Col[r][c];Rows[a]++;Row[a][Rows[a]]=r;}
+no=0;for(i=1;i<=N4;i++){for(x=symmap(i);x!=i;x=symmap(x))if(x<i)break;
+  if(x<i)continue;no++;On[no]=0;x=i;do{Ob[no][On[no]++]=x;x=symmap(x);}while(x!=i);}
 
 if((file=fopen(argv[1],"rt"))==NULL)
   {fclose(file);printf("\nfile-error\n\n");exit(1);}
 
 
 m0:for(i=1;i<=81;i++){
-mip:A[i]=fgetc(file)-48;if(feof(file))exit(8);
+mip:A[i]=fgetc(file)-48;if(feof(file)){
+      fprintf(stderr,"%lld removals: %lld rejected by unavoidable sets, %lld of %lld checks"
+        " known unique  %.1f%% without solving\n",utries,uhits,chits,cprobes,
+        utries?100.0*(uhits+chits)/utries:0.0);exit(8);}
     if(A[i]==-2)A[i]=0;
     if(A[i]>9)A[i]-=7;if(A[i]<0)goto mip;}
 
-if(solve(2)!=1)goto m0;
+why=0;pnodes=0;dl0=msec();tried=0;
+clues0=0;for(i=1;i<=N4;i++)if(A[i])clues0++;
+if((u=solve(2))==-2)goto m8;
+if(u!=1)goto m0;
+for(i=1;i<=N4;i++){Sol[i]=Ws[1][i];A0[i]=A[i];}
+for(c=1;c<=m;c++)for(k=1;k<=Rows[c];k++){r=Row[c][k];
+  if(Sol[(r-1)/(N2)+1]==(r-1)%(N2)+1)Q[c]=k;}
+unavoidable();nq=0;
 
-mh7:for(i=1;i<=N4;i++){mr4:x=MWC&127;if(x>=i)goto mr4;x++;P[i]=P[x];P[x]=i;}
-for(i1=1;i1<=N4;i1++)if(A[P[i1]]){s1=A[P[i1]];
-   A[P[i1]]=0;if(solve(2)>1)A[P[i1]]=s1;}
+for(rs=1;rs<=restarts && !why;rs++){tried=0;
+if(rs>1 && nq<QS){Kq[nq][0]=K[0];Kq[nq][1]=K[1];nq++;}
+K[0]=K[1]=0;for(i=1;i<=N4;i++){A[i]=A0[i];
+  if(A[i])K[(i-1)>>6]|=1ULL<<((i-1)&63);}
+mh7:for(i=1;i<=no;i++){mr4:x=MWC&127;if(x>=i)goto mr4;x++;P[i]=P[x];P[x]=i;}
+for(i1=1;i1<=no;i1++){o=P[i1];
+   for(t=0,u=0;t<On[o];t++){p=Ob[o][t];S[p]=A[p];
+     if(A[p]){u++;A[p]=0;K[(p-1)>>6]^=1ULL<<((p-1)&63);}}
+   if(!u)continue;utries++;tried+=u;
+   for(t=0,u=0;t<On[o];t++)if(S[Ob[o][t]] && uforced(Ob[o][t]))u=3;
+   if(u)uhits++;else u=tsolve();
+   if(u>1 || u==-2)for(t=0;t<On[o];t++){p=Ob[o][t];
+     if(S[p]){A[p]=S[p];K[(p-1)>>6]^=1ULL<<((p-1)&63);}}
+   if(u==-2)break;}
 
+m8:if(why)printf("incomplete(%s) ",why);
 if(sd)print_board();
-if(!sd){for(i=1;i<=N4;i++)printf("%c",L[A[i]]);printf("\n");}
+if(!sd)for(i=1;i<=N4;i++)printf("%c",L[A[i]]);
+if(why)printf("  %i of %i clues tried  %lld nodes",tried,clues0,pnodes);
+if(!sd)printf("\n");
+if(stop)exit(2);}
 goto m0;return 0;}
 
 
 
+long long msec(){
+struct timespec ts;
+clock_gettime(CLOCK_MONOTONIC,&ts);return ts.tv_sec*1000LL+ts.tv_nsec/1000000;}
+
+void cancel(int sig){(void)sig;stop=1;}
+
+/* 1 if the current sudoku ran out of time or nodes or got a signal */
+int halted(){
+if(stop)why="cancelled";
+else if(vmax && pnodes>=vmax)why="nodes";
+else if(dl && !(pnodes&1023) && msec()>=dl0+dl)why="deadline";
+return why!=0;}
+
+
+
+/* fills the bank with the unavoidable rectangles of the grid in Sol:
+   cells x1y1 x1y2 x2y1 x2y2 in two boxes holding a b / b a. finding them
+   needs no solving, the witnesses of the checks add the larger sets */
+void unavoidable(){
+int t,u,w,x1,x2,y1,y2;
+
+us=0;
+for(x1=0;x1<N2;x1++)for(x2=x1+1;x2<N2;x2++)for(y1=0;y1<N2;y1++)for(y2=y1+1;y2<N2;y2++){
+  if((x1/N==x2/N)==(y1/N==y2/N) || us==US)continue;
+  if(Sol[x1*N2+y1+1]!=Sol[x2*N2+y2+1] || Sol[x1*N2+y2+1]!=Sol[x2*N2+y1+1])continue;
+  U[us][0]=U[us][1]=0;
+  for(t=0;t<4;t++){u=(t<2?x1:x2)*N2+(t&1?y2:y1);U[us][u>>6]|=1ULL<<(u&63);}
+  us++;}
+for(t=1;t<=N4;t++)for(w=0;w<US/64;w++)H[t][w]=0;
+for(u=0;u<us;u++)for(t=1;t<=N4;t++)if(U[u][(t-1)>>6]>>((t-1)&63)&1)
+  H[t][u>>6]|=1ULL<<(u&63);
+uw=uw0=us<US-US/4?us:US-US/4;}
+
+
+
+/* puts the set a,b into the bank, in place of the oldest witness if full */
+void uadd(unsigned long long a,unsigned long long b){
+int t,u;
+
+if(us<US)u=us++;else{u=uw;if(++uw==US)uw=uw0;}
+for(t=1;t<=N4;t++)if(U[u][(t-1)>>6]>>((t-1)&63)&1)H[t][u>>6]&=~(1ULL<<(u&63));
+U[u][0]=a;U[u][1]=b;
+for(t=1;t<=N4;t++)if(U[u][(t-1)>>6]>>((t-1)&63)&1)H[t][u>>6]|=1ULL<<(u&63);}
+
+
+
+/* 1 if a set of the bank through the removed clue p has no clue left in K */
+int uforced(int p){
+int w;unsigned long long b,*u;
+
+for(w=0;w<US/64;w++)for(b=H[p][w];b;b&=b-1){u=U[64*w+__builtin_ctzll(b)];
+  if(!(u[0]&K[0]) && !(u[1]&K[1]))return 1;}
+return 0;}
+
+
+
+/* image of cell p under the symmetry sym */
+int symmap(int p){
+int x=(p-1)/(N2),y=(p-1)%(N2);
+
+if(sym=='2')return (N2-1-x)*N2+N2-1-y+1;
+if(sym=='4')return y*N2+N2-1-x+1;
+if(sym=='d')return y*N2+x+1;
+if(sym=='m')return x*N2+N2-1-y+1;
+return p;}
+
+
+
+/* other() with what the earlier checks of the grid found: 1 for a clue
+   set that contains the clues of a finished restart, else other(), and
+   a witness goes into the bank. returns 1 or 2, -2 if halted */
+int tsolve(){
+int t,u;unsigned long long a[2]={0,0};
+
+cprobes++;
+for(t=0;t<nq;t++)if(!(Kq[t][0]&~K[0]) && !(Kq[t][1]&~K[1])){chits++;return 1;}
+u=other();
+if(u==2){for(t=1;t<=N4;t++)if(Ws[0][t]!=Sol[t])a[(t-1)>>6]|=1ULL<<((t-1)&63);
+  uadd(a[0],a[1]);}
+return u;}
+
+
+
+/* 1 if Sol is the only solution of A, 2 with another one in Ws[0], -2
+   if halted. keeps the MWC stream, so the removal order of a seed does
+   not depend on the checks */
+int other(){
+int t,x,y,u,h;unsigned zr0=zr,wr0=wr;
+
+for(t=0;t<N2;t++)Mr[t]=Mc[t]=Mb[t]=0;
+for(t=1,h=0;t<=N4;t++){Ws[0][t]=A[t];
+  if(!A[t]){Ho[h++]=t;continue;}
+  x=(t-1)/(N2);y=(t-1)%(N2);u=1<<A[t];Mr[x]|=u;Mc[y]|=u;Mb[x/N*N+y/N]|=u;}
+if(h<=HMAX)return holes(h,0);
+dif=1;u=solve(2);dif=0;zr=zr0;wr=wr0;
+return u;}
+
+
+
+/* fill the h holes in Ho, d>0 once a value differs from Sol */
+int holes(int h,int d){
+int t,b=0,x,y,p,q,u,v,min=N2+1;
+
+if(!h)return d?2:1;
+for(t=0;t<h;t++){p=Ho[t];x=(p-1)/(N2);y=(p-1)%(N2);
+  u=__builtin_popcount(~(Mr[x]|Mc[y]|Mb[x/N*N+y/N])&((2<<N2)-2));
+  if(u<min){min=u;b=t;if(u<2)break;}}
+if(!min)return 1;
+p=Ho[b];Ho[b]=Ho[h-1];Ho[h-1]=p;
+x=(p-1)/(N2);y=(p-1)%(N2);q=x/N*N+y/N;
+u=~(Mr[x]|Mc[y]|Mb[q])&((2<<N2)-2);
+/* Sol's value last */
+u=(u&~(1<<Sol[p]))|(u>>Sol[p]&1)<<(N2+1);
+for(;u;u&=u-1){v=__builtin_ctz(u);if(v>N2)v=Sol[p];
+  pnodes++;if(stop || vmax || dl)if(halted())return -2;
+  Mr[x]|=1<<v;Mc[y]|=1<<v;Mb[q]|=1<<v;Ws[0][p]=v;
+  t=holes(h-1,d || v!=Sol[p]);
+  Mr[x]^=1<<v;Mc[y]^=1<<v;Mb[q]^=1<<v;
+  if(t!=1)return t;}
+return 1;}
+
+
+
 int solve(smax){
+int t,u,w;unsigned long long b;
 
 s0:for(i=0;i<=n;i++)Ur[i]=0;for(i=0;i<=m;i++)Uc[i]=0;
    clues=0;for(i=1;i<=N4;i++)
@@ -66,31 +289,43 @@ s0:for(i=0;i<=n;i++)Ur[i]=0;for(i=0;i<=m;i++)Uc[i]=0;
        for(j=1;j<=Cols[r];j++){d=Col[r][j];if(Uc[d])return -1;Uc[d]++;
          for(k=1;k<=Rows[d];k++){Ur[Row[d][k]]++;}}}
    for(c=1;c<=m;c++){V[c]=0;for(r=1;r<=Rows[c];r++)if(Ur[Row[c][r]]==0)V[c]++;}
-if(clues==N4)return 1;
+if(clues==N4){for(t=1;t<=N4;t++)Ws[1][t]=A[t];return 1;}
+   for(t=0;t<=N2;t++){Bn[t]=0;for(w=0;w<BW;w++)B[t][w]=0;}
+   for(c=1;c<=m;c++)if(!Uc[c])BIN(c);
 
    i=clues;m0=0;m1=0;solutions=0;nodes=0;
 m2:i++;I[i]=0;min=n+1;if(i>N4 || m0)goto m4;
    if(m1){C[i]=m1;goto m3;}
-   for(c=1;c<=m;c++)if(!Uc[c]){if(V[c]<=min)c1=c;
-     if(V[c]<min){min=V[c];C[i]=c;if(min<2)goto m3;}}
-   if(min>2)goto m3;
+// the first column with V<2, else the first one with the fewest rows
+   if(Bn[0]+Bn[1]){for(w=0;!(b=B[0][w]|B[1][w]);w++);C[i]=w*64+__builtin_ctzll(b);goto m3;}
+   for(min=2;min<N2 && !Bn[min];min++);
+   if(min>2){for(w=0;!(b=B[min][w]);w++);C[i]=w*64+__builtin_ctzll(b);goto m3;}
 
+// V==2 ties: the first one from a random column on, cyclically
 mr5:c1=MWC&511;if(c1>=m)goto mr5;c1++;
-   for(c=c1;c<=m;c++)if(!Uc[c])if(V[c]==2){C[i]=c;goto m3;}
-   for(c=1;c<c1;c++)if(!Uc[c])if(V[c]==2){C[i]=c;goto m3;}
+   w=c1>>6;b=B[2][w]&(~0ULL<<(c1&63));
+   while(!b){w++;if(w==BW)w=0;b=B[2][w];}
+   C[i]=w*64+__builtin_ctzll(b);
 
 m3:c=C[i];I[i]++;if(I[i]>Rows[c])goto m4;
-   r=Row[c][I[i]];if(Ur[r])goto m3;m0=0;m1=0;
-   for(j=1;j<=Cols[r];j++){c1=Col[r][j];Uc[c1]++;}
+   k=I[i];if(dif)k=k<Q[c]?k:k<Rows[c]?k+1:Q[c];
+   r=R[i]=Row[c][k];if(Ur[r])goto m3;m0=0;m1=0;
+   for(j=1;j<=Cols[r];j++){c1=Col[r][j];if(!Uc[c1])BOUT(c1);Uc[c1]++;}
    for(j=1;j<=Cols[r];j++){c1=Col[r][j];
       for(k=1;k<=Rows[c1];k++){r1=Row[c1][k];Ur[r1]++;if(Ur[r1]==1)
-         for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];V[c2]--;
-            if(Uc[c2]+V[c2]<1)m0=c2;if(Uc[c2]==0 && V[c2]<2)m1=c2;}}}
-   if(i==N4)solutions++;if(solutions>smax)goto m9;goto m2;
-m4:i--;c=C[i];r=Row[c][I[i]];if(i==clues)goto m9;
-   for(j=1;j<=Cols[r];j++){c1=Col[r][j];Uc[c1]--;
+         for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];if(Uc[c2]){V[c2]--;continue;}BDEC(c2);
+            if(V[c2]<1)m0=c2;if(V[c2]<2)m1=c2;}}}
+   pnodes++;if(stop || vmax || dl)if(halted())return -2;
+   if(i==N4){solutions++;for(t=1;t<=N4;t++)Ws[solutions&1][t]=A[t];
+     for(t=clues+1;t<=N4;t++){u=R[t];Ws[solutions&1][(u-1)/(N2)+1]=(u-1)%(N2)+1;}
+     if(dif){for(t=1;t<=N4 && Ws[1][t]==Sol[t];t++);
+       if(t<=N4){for(t=1;t<=N4;t++)Ws[0][t]=Ws[1][t];solutions=2;goto m9;}}
+}
+   if(solutions>smax)goto m9;goto m2;
+m4:i--;c=C[i];r=R[i];if(i==clues)goto m9;
+   for(j=1;j<=Cols[r];j++){c1=Col[r][j];Uc[c1]--;if(!Uc[c1])BIN(c1);
       for(k=1;k<=Rows[c1];k++){r1=Row[c1][k];Ur[r1]--;
-         if(Ur[r1]==0)for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];V[c2]++;}}}
+         if(Ur[r1]==0)for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];if(Uc[c2])V[c2]++;else BINC(c2);}}}
    if(i>clues)goto m3;
 m9:return solutions;}
 
@@ -0,0 +1,316 @@
+/*
+ * Search puzzles whose clues sit on a given pattern.
+ *
+ * A worker takes a random solution grid and tries random placements of
+ * the pattern on it. A placement is one of the 2*6^8 band, stack, row,
+ * column and transposition maps of the grid, and the clues are the cells
+ * of the mapped grid under the pattern, so each placement is a different
+ * puzzle with the wanted shape. It is unique iff no unavoidable set of
+ * the grid misses all of its clue cells.
+ *
+ * The placements on one grid share what the uniqueness checks found:
+ * every non-unique placement gives an unavoidable set of the grid (the
+ * cells where the other solution differs from it), and the grid starts
+ * with its unavoidable rectangles. A placement that misses one of the
+ * known sets is rejected with a bit mask test; only the others go to
+ * the exact cover solver. The more placements a grid gets the more of
+ * them are rejected that way, so a grid is kept for many of them (the
+ * same placement can come up again; its puzzle is printed once) before
+ * the worker moves on to a new one.
+ *
+ * Usage:
+ * ./patsearch [-j4] [-n10] [-t60] [-s1] [-p100000] pattern
+ *   pattern is a file or a string of 81 cells, x (#, *, 1-9) for a clue
+ *   and . (0) for an empty cell; whitespace and the -, |, + of a grid
+ *   drawing are ignored. -n stops after n puzzles, -t after t seconds (else
+ *   at SIGINT), -s seeds the workers, -p is the number of placements
+ *   per grid. Puzzles go to stdout, the rate to stderr every 10 s.
+ *
+ * Compile (example):
+ * g++ -std=c++17 -O2 -pthread patsearch.cc -o patsearch
+ */
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <iostream>
+#include <fstream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdint.h>
+#include "../exactcover/exactcover.h"
+
+/* a set of cells, bit i%64 of word i/64 for cell i */
+struct cells
+{
+    uint64_t w[2];
+    void add(int i) { w[i >> 6] |= 1ULL << (i & 63); }
+    bool has(int i) const { return w[i >> 6] >> (i & 63) & 1; }
+    bool meets(const cells &o) const { return (w[0] & o.w[0]) | (w[1] & o.w[1]); }
+};
+
+static bool pattern[81];
+static long long max_puzzles = 0, placements = 100000;
+static std::atomic<long long> found(0), tried(0), pruned(0), grids(0);
+static std::atomic<bool> stop(false);
+static std::mutex out_lock;
+
+static void cancel(int) { stop = true; }
+
+/* xorshift64* generator, one per worker */
+struct rng
+{
+    uint64_t s;
+    uint64_t next() {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    }
+    int below(int n) { return next() % n; }
+};
+
+static void shuffle(int *a, int n, rng &g)
+{
+    for (int i=0; i<n; i++)
+        a[i] = i;
+    for (int i=n-1; i>0; i--)
+        std::swap(a[i], a[g.below(i+1)]);
+}
+
+/* a random solution grid: a few random clues, then the first completion */
+static void random_grid(ec::sudoku &solver, rng &g, int *grid)
+{
+    for (;;) {
+        int p[81] = {0};
+        for (int k=0; k<11; k++) {
+            int i = g.below(81), v = 1 + g.below(9);
+            bool ok = !p[i];
+            for (int j=0; ok && j<81; j++)
+                if (p[j] == v && (j/9 == i/9 || j%9 == i%9 ||
+                                  (j/27 == i/27 && j%9/3 == i%9/3)))
+                    ok = false;
+            if (ok)
+                p[i] = v;
+        }
+        if (solver.count(p, 1, 0, grid).count)
+            return;
+    }
+}
+
+/*
+ * the unavoidable rectangles of a grid: two rows and two columns whose
+ * four cells lie in two boxes and hold a b / b a
+ */
+static void rectangles(const int *grid, std::vector<cells> &sets)
+{
+    for (int r1=0; r1<9; r1++)
+        for (int r2=r1+1; r2<9; r2++)
+            for (int c1=0; c1<9; c1++)
+                for (int c2=c1+1; c2<9; c2++) {
+                    if ((r1/3 == r2/3) == (c1/3 == c2/3))
+                        continue;
+                    if (grid[r1*9+c1] != grid[r2*9+c2] || grid[r1*9+c2] != grid[r2*9+c1])
+                        continue;
+                    cells u = {{0, 0}};
+                    u.add(r1*9+c1);
+                    u.add(r1*9+c2);
+                    u.add(r2*9+c1);
+                    u.add(r2*9+c2);
+                    sets.push_back(u);
+                }
+}
+
+/*
+ * a random placement: pos[i] is where cell i of the grid goes, and
+ * clues the cells of the grid that land on the pattern
+ */
+static void placement(rng &g, int *pos, cells &clues)
+{
+    int map[2][9];
+    for (int d=0; d<2; d++) {
+        int outer[3], inner[3];
+        shuffle(outer, 3, g);
+        for (int b=0; b<3; b++) {
+            shuffle(inner, 3, g);
+            for (int k=0; k<3; k++)
+                map[d][b*3+k] = outer[b]*3 + inner[k];
+        }
+    }
+    bool t = g.below(2);
+    clues.w[0] = clues.w[1] = 0;
+    for (int i=0; i<81; i++) {
+        int y = map[0][i/9], x = map[1][i%9];
+        pos[i] = t ? x*9+y : y*9+x;
+        if (pattern[pos[i]])
+            clues.add(i);
+    }
+}
+
+static void worker(uint64_t seed)
+{
+    rng g;
+    g.s = seed * 0x9e3779b97f4a7c15ULL + 1;
+    ec::sudoku solver(3, {}, {}, {}, {});
+    int grid[81], p[81], first[81], last[81], pos[81];
+    std::vector<cells> sets;
+    std::unordered_set<std::string> seen;
+
+    while (!stop) {
+        random_grid(solver, g, grid);
+        grids++;
+        sets.clear();
+        seen.clear();
+        rectangles(grid, sets);
+        for (long long n=0; n<placements && !stop; n++) {
+            cells clues;
+            placement(g, pos, clues);
+            tried++;
+            size_t k = 0;
+            while (k < sets.size() && sets[k].meets(clues))
+                k++;
+            if (k < sets.size()) {
+                pruned++;
+                /* keep the sets that reject often at the front */
+                if (k)
+                    std::swap(sets[k], sets[k-1]);
+                continue;
+            }
+            for (int i=0; i<81; i++)
+                p[i] = clues.has(i) ? grid[i] : 0;
+            if (solver.count(p, 2, 0, first, last).count > 1) {
+                const int *other = std::equal(first, first+81, grid) ? last : first;
+                cells u = {{0, 0}};
+                for (int i=0; i<81; i++)
+                    if (other[i] != grid[i])
+                        u.add(i);
+                sets.push_back(u);
+                continue;
+            }
+            char line[83];
+            for (int i=0; i<81; i++)
+                line[pos[i]] = p[i] ? '0' + p[i] : '.';
+            line[81] = '\n';
+            line[82] = 0;
+            if (!seen.insert(line).second)
+                continue;
+            std::lock_guard<std::mutex> lock(out_lock);
+            if (max_puzzles && found >= max_puzzles) {
+                stop = true;
+                break;
+            }
+            std::fputs(line, stdout);
+            std::fflush(stdout);
+            if (++found == max_puzzles)
+                stop = true;
+        }
+    }
+}
+
+static bool read_pattern(const char *arg)
+{
+    std::string text;
+    std::ifstream f(arg);
+    if (f)
+        text.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    else
+        text = arg;
+    int n = 0;
+    for (size_t k=0; k<text.size(); k++) {
+        char c = text[k];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r' || c == '|' || c == '+' || c == '-')
+            continue;
+        if (n == 81)
+            return false;
+        if (c == '.' || c == '0')
+            pattern[n++] = false;
+        else if (c == 'x' || c == 'X' || c == '#' || c == '*' || (c >= '1' && c <= '9'))
+            pattern[n++] = true;
+        else
+            return false;
+    }
+    return n == 81;
+}
+
+static void report(double seconds)
+{
+    char buf[160];
+    std::snprintf(buf, sizeof(buf),
+                  "%lld puzzles  %.1f/min  %lld grids  %lld placements  %.1f%% pruned  %.0f s\n",
+                  found.load(), seconds > 0 ? found * 60.0 / seconds : 0.0, grids.load(),
+                  tried.load(), tried ? 100.0 * pruned / tried : 0.0, seconds);
+    std::fputs(buf, stderr);
+}
+
+int main(int argc, char **argv)
+{
+    const char *pat = 0;
+    int threads = std::thread::hardware_concurrency();
+    long long seconds = 0;
+    uint64_t seed = 0;
+
+    for (int k=1; k<argc; k++) {
+        if (argv[k][0] == '-' && argv[k][1] == 'j')
+            threads = std::atoi(argv[k]+2);
+        else if (argv[k][0] == '-' && argv[k][1] == 'n')
+            max_puzzles = std::atoll(argv[k]+2);
+        else if (argv[k][0] == '-' && argv[k][1] == 't')
+            seconds = std::atoll(argv[k]+2);
+        else if (argv[k][0] == '-' && argv[k][1] == 's')
+            seed = std::strtoull(argv[k]+2, 0, 10);
+        else if (argv[k][0] == '-' && argv[k][1] == 'p')
+            placements = std::atoll(argv[k]+2);
+        else if (argv[k][0] != '-')
+            pat = argv[k];
+        else
+            pat = 0, k = argc;
+    }
+    if (!pat) {
+        std::cerr << "Usage: " << argv[0] << " [-j4] [-n10] [-t60] [-s1] [-p100000] pattern"
+                  << std::endl;
+        return 1;
+    }
+    if (!read_pattern(pat)) {
+        std::cerr << "error: pattern needs 81 cells of x and ." << std::endl;
+        return 1;
+    }
+    if (std::count(pattern, pattern+81, true) < 17) {
+        std::cerr << "error: no pattern with less than 17 clues has a unique puzzle" << std::endl;
+        return 1;
+    }
+    if (threads < 1)
+        threads = 1;
+    if (placements < 1)
+        placements = 1;
+    std::signal(SIGINT, cancel);
+    std::signal(SIGTERM, cancel);
+
+    if (!seed)
+        seed = std::chrono::steady_clock::now().time_since_epoch().count();
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> pool;
+    for (int t=0; t<threads; t++)
+        pool.push_back(std::thread(worker, seed + t));
+
+    /* rate every 10 s until the workers stop */
+    double elapsed = 0;
+    for (int tick=1; !stop; tick++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (seconds && elapsed >= seconds)
+            stop = true;
+        if (tick % 100 == 0)
+            report(elapsed);
+    }
+    for (size_t t=0; t<pool.size(); t++)
+        pool[t].join();
+    report(std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    return 0;
+}
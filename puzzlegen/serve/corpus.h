@@ -0,0 +1,137 @@
+/*
+ * Binary puzzle corpus, written by mkcorpus and mapped into memory by
+ * puzzled.
+ *
+ * Every entry holds a solution grid and the clue mask of its puzzle,
+ * together with the keys a client filters on: the number of clues, a
+ * rating and the equivalence class of the top band (the cls of
+ * bandtable.h, CORPUS_NOCLASS if the corpus was built without a
+ * table). Entries are sorted by (clues, rating, cls) and the groups of
+ * equal keys are listed in front of them, so the entries matching a
+ * clue count and a rating range are one contiguous run and a random
+ * pick needs a binary search over the groups and no scan.
+ *
+ * Layout: corpus_header, corpus_group[groups], corpus_entry[count].
+ * Like bandtable.h the file is mapped as is and only meant to be read
+ * on the machine (endianness) that wrote it.
+ */
+
+#ifndef CORPUS_H
+#define CORPUS_H
+
+#include <stdint.h>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#define CORPUS_MAGIC "SUDCORP"
+#define CORPUS_VERSION 1
+#define CORPUS_NOCLASS (~(uint32_t)0)
+
+struct corpus_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t groups;
+    uint64_t count;
+};
+
+/* the entries [begin, end) share clues, rating and cls */
+struct corpus_group
+{
+    uint8_t clues, rating;
+    uint8_t pad[2];
+    uint32_t cls;
+    uint64_t begin, end;
+};
+
+struct corpus_entry
+{
+    /* solution, two cells per byte (high nibble first), values 1..9 */
+    uint8_t grid[41];
+    /* bit i set if cell i is a clue */
+    uint8_t mask[11];
+    uint8_t clues, rating;
+    uint8_t pad[2];
+    uint32_t cls;
+};
+
+struct corpus
+{
+    corpus_header *header;
+    corpus_group *group;
+    corpus_entry *entry;
+    size_t bytes;
+};
+
+/* sort order of entries and groups */
+static inline bool corpus_less(int clues1, int rating1, uint32_t cls1,
+                               int clues2, int rating2, uint32_t cls2)
+{
+    if (clues1 != clues2)
+        return clues1 < clues2;
+    if (rating1 != rating2)
+        return rating1 < rating2;
+    return cls1 < cls2;
+}
+
+static inline int corpus_cell(const corpus_entry &e, int i)
+{
+    return i & 1 ? e.grid[i/2] & 15 : e.grid[i/2] >> 4;
+}
+
+static inline bool corpus_clue(const corpus_entry &e, int i)
+{
+    return e.mask[i/8] >> (i%8) & 1;
+}
+
+/* fill an entry from a solution (1..9) and a puzzle (0 for holes) */
+static inline void corpus_pack(corpus_entry &e, const int *grid, const int *puzzle)
+{
+    std::memset(&e, 0, sizeof(e));
+    for (int i=0; i<81; i++) {
+        e.grid[i/2] |= i & 1 ? grid[i] : grid[i] << 4;
+        if (puzzle[i]) {
+            e.mask[i/8] |= 1 << (i%8);
+            e.clues++;
+        }
+    }
+}
+
+/* map a corpus read only; false if the file is missing or not a corpus */
+static inline bool corpus_map(corpus &c, const char *path)
+{
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(corpus_header)) {
+        close(fd);
+        return false;
+    }
+    void *p = mmap(0, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED)
+        return false;
+    c.header = (corpus_header *)p;
+    c.group = (corpus_group *)(c.header+1);
+    c.entry = (corpus_entry *)(c.group + c.header->groups);
+    c.bytes = st.st_size;
+    if (std::memcmp(c.header->magic, CORPUS_MAGIC, 8) != 0 ||
+        c.header->version != CORPUS_VERSION ||
+        c.bytes < sizeof(corpus_header) + c.header->groups*sizeof(corpus_group)
+                  + c.header->count*sizeof(corpus_entry)) {
+        munmap(p, c.bytes);
+        return false;
+    }
+    return true;
+}
+
+static inline void corpus_unmap(corpus &c)
+{
+    munmap(c.header, c.bytes);
+}
+
+#endif
@@ -0,0 +1,233 @@
+/*
+ * Build a puzzle corpus for puzzled (format in corpus.h).
+ *
+ * The input is scanned for 81 character runs of digits and dots, so
+ * the puzzle lists of this repository can be used as they are: lines
+ * of puzzles (raw_17s.txt), the JSON of genpuzzles.py or the arrays in
+ * src/data/sudoku. A run without holes is a solution grid and is
+ * paired with the puzzle that follows it, otherwise the puzzle is
+ * solved. Puzzles without a unique solution, or whose solution does
+ * not match the grid given with them, are dropped, as are duplicates.
+ *
+ * The rating of a puzzle is 0 if the exact cover search of
+ * exactcover.h never has to guess, i.e. naked and hidden singles
+ * solve it, and 1 + log2(guesses) otherwise (at most 15), counting the
+ * guesses of the search that also proves uniqueness. With -t the class
+ * is the equivalence class of the top band of the solution in a table
+ * written by "sudoku_equiv -w".
+ *
+ * Usage:
+ * ./mkcorpus [-t bands.tbl] out.corpus [file...]
+ *   (no file reads standard input)
+ *
+ * Compile (example):
+ * g++ -std=c++17 -O2 mkcorpus.cc -o mkcorpus
+ */
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <map>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include "corpus.h"
+#include "../exactcover/exactcover.h"
+#include "../equiv_method/original_code/bandtable.h"
+
+/* classes of the top band configurations, empty without -t */
+static std::map<std::string, uint32_t> classes;
+
+/*
+ * the top band of a grid in the reduced form of sudoku_equiv: box 1
+ * relabelled to 123/456/789, the columns of boxes 2 and 3 sorted by
+ * their first row and box 2 before box 3, as canonize() in
+ * sudoku_verify.cc
+ */
+static std::string top_band(const int *grid)
+{
+    int b[27], trans[10];
+    for (int i=0; i<9; i++)
+        trans[grid[(i/3)*9+i%3]] = i+1;
+    for (int i=0; i<27; i++)
+        b[i] = trans[grid[i]];
+    auto swap_column = [&](int c1, int c2) {
+        for (int y=0; y<3; y++)
+            std::swap(b[y*9+c1], b[y*9+c2]);
+    };
+    for (int k=3; k<9; k+=3) {
+        if (b[k] > b[k+1])
+            swap_column(k, k+1);
+        if (b[k+1] > b[k+2])
+            swap_column(k+1, k+2);
+        if (b[k] > b[k+1])
+            swap_column(k, k+1);
+    }
+    if (b[3] > b[6])
+        for (int k=0; k<3; k++)
+            swap_column(3+k, 6+k);
+    std::string s;
+    for (int y=0; y<3; y++) {
+        if (y)
+            s += ',';
+        for (int x=3; x<9; x++)
+            s += '0' + b[y*9+x];
+    }
+    return s;
+}
+
+struct builder
+{
+    ec::sudoku solver;
+    std::vector<corpus_entry> entries;
+    long long read, dropped;
+
+    builder() : solver(3, {}, {}, {}, {}), read(0), dropped(0) {}
+
+    /* add puzzle p (0 for holes), with its solution g if not 0 */
+    void add(const int *p, const int *g)
+    {
+        int sol[81];
+        read++;
+        ec::result res = solver.count(p, 2, 0, sol);
+        if (res.count != 1 || (g && !std::equal(sol, sol+81, g))) {
+            dropped++;
+            return;
+        }
+        corpus_entry e;
+        corpus_pack(e, sol, p);
+        int r = 0;
+        while (r < 15 && res.guesses >> r)
+            r++;
+        e.rating = r;
+        e.cls = CORPUS_NOCLASS;
+        if (!classes.empty()) {
+            auto it = classes.find(top_band(sol));
+            if (it != classes.end())
+                e.cls = it->second;
+        }
+        entries.push_back(e);
+    }
+
+    /* scan a stream for grids and puzzles */
+    void scan(std::FILE *f)
+    {
+        int tok[81], grid[81];
+        int len = 0, holes = 0;
+        bool have_grid = false;
+        for (int ch; ; ) {
+            ch = std::fgetc(f);
+            if ((ch >= '0' && ch <= '9') || ch == '.') {
+                if (len < 81) {
+                    tok[len] = ch == '.' ? 0 : ch-'0';
+                    holes += !tok[len];
+                }
+                len++;
+                continue;
+            }
+            if (len == 81) {
+                if (!holes) {
+                    if (have_grid)
+                        add(grid, 0);
+                    std::copy(tok, tok+81, grid);
+                    have_grid = true;
+                } else {
+                    add(tok, have_grid ? grid : 0);
+                    have_grid = false;
+                }
+            }
+            len = holes = 0;
+            if (ch == EOF)
+                break;
+        }
+        if (have_grid)
+            add(grid, 0);
+    }
+};
+
+static bool entry_less(const corpus_entry &a, const corpus_entry &b)
+{
+    if (a.clues != b.clues || a.rating != b.rating || a.cls != b.cls)
+        return corpus_less(a.clues, a.rating, a.cls, b.clues, b.rating, b.cls);
+    return std::memcmp(&a, &b, sizeof(a)) < 0;
+}
+
+static bool entry_equal(const corpus_entry &a, const corpus_entry &b)
+{
+    return std::memcmp(&a, &b, sizeof(a)) == 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 2 && std::strcmp(argv[1], "-t") == 0) {
+        band_table table;
+        if (!band_map(table, argv[2], false)) {
+            std::cerr << "error: can't map table " << argv[2] << std::endl;
+            return 1;
+        }
+        for (uint32_t i=0; i<table.header->count; i++)
+            classes[table.entry[i].config] = table.entry[i].cls;
+        band_unmap(table);
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " [-t bands.tbl] out.corpus [file...]"
+                  << std::endl;
+        return 1;
+    }
+
+    builder b;
+    if (argc == 2)
+        b.scan(stdin);
+    for (int k=2; k<argc; k++) {
+        std::FILE *f = std::fopen(argv[k], "r");
+        if (!f) {
+            std::cerr << "error: can't read " << argv[k] << std::endl;
+            return 1;
+        }
+        b.scan(f);
+        std::fclose(f);
+    }
+
+    std::vector<corpus_entry> &e = b.entries;
+    std::sort(e.begin(), e.end(), entry_less);
+    size_t dups = e.size();
+    e.erase(std::unique(e.begin(), e.end(), entry_equal), e.end());
+    dups -= e.size();
+
+    std::vector<corpus_group> groups;
+    for (size_t i=0; i<e.size(); i++) {
+        if (groups.empty() || groups.back().clues != e[i].clues ||
+            groups.back().rating != e[i].rating || groups.back().cls != e[i].cls) {
+            corpus_group g;
+            std::memset(&g, 0, sizeof(g));
+            g.clues = e[i].clues;
+            g.rating = e[i].rating;
+            g.cls = e[i].cls;
+            g.begin = i;
+            groups.push_back(g);
+        }
+        groups.back().end = i+1;
+    }
+
+    corpus_header h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, CORPUS_MAGIC, 8);
+    h.version = CORPUS_VERSION;
+    h.groups = groups.size();
+    h.count = e.size();
+    std::FILE *out = std::fopen(argv[1], "wb");
+    if (!out ||
+        std::fwrite(&h, sizeof(h), 1, out) != 1 ||
+        std::fwrite(groups.data(), sizeof(corpus_group), groups.size(), out) != groups.size() ||
+        std::fwrite(e.data(), sizeof(corpus_entry), e.size(), out) != e.size() ||
+        std::fclose(out) != 0) {
+        std::cerr << "error: can't write " << argv[1] << std::endl;
+        return 1;
+    }
+    std::cout << b.read << " puzzles, " << b.dropped << " not unique or not matching, "
+              << dups << " duplicates, " << e.size() << " in "
+              << groups.size() << " groups" << std::endl;
+    return 0;
+}
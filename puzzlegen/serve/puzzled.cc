@@ -0,0 +1,411 @@
+/*
+ * Serve random puzzles from a corpus built by mkcorpus over HTTP, on a
+ * local TCP port or a Unix socket, so the client can ask for a puzzle
+ * instead of shipping the puzzle arrays.
+ *
+ * GET /puzzle[?clues=17&rating=2-5&class=12&geo=1]
+ *   a random puzzle of the corpus matching the filter: clues and
+ *   rating take a number or a range lo-hi, class the class of the top
+ *   band (see mkcorpus). The answer is the JSON object of the puzzle
+ *   arrays of src/data/sudoku, {"puzzle": solution, "minimal": puzzle
+ *   with dots}, plus the keys of the entry. Like randomSwaps in
+ *   src/lib/sudoku.ts the digits are relabelled at random; geo=1 also
+ *   permutes bands, stacks, rows and columns and transposes at random
+ *   (this keeps clues and rating, but not the class of the top band,
+ *   so the answer has "class": null; the class filter still applies).
+ *   404 if nothing matches.
+ * GET /stats
+ *   the number of entries and the groups of the corpus as
+ *   [clues, rating, class, entries].
+ *
+ * The corpus is mapped read only and shared by all workers. Entries
+ * are sorted by (clues, rating, class), so a filter becomes one run of
+ * entries per clue count (or per clue count and rating if a class is
+ * given), found by binary search in the group table; the time of a
+ * pick does not depend on the size of the corpus.
+ *
+ * Usage:
+ * ./puzzled [-p8080 | -u path] [-j4] file.corpus
+ *   (-p listens on 127.0.0.1:port, -u on a Unix socket; default -p8080)
+ *
+ * Compile (example):
+ * g++ -std=c++17 -O2 -pthread puzzled.cc -o puzzled
+ */
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <csignal>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "corpus.h"
+
+static corpus db;
+
+/* xorshift64* generator, one per worker */
+struct rng
+{
+    uint64_t s;
+    uint64_t next() {
+        s ^= s >> 12;
+        s ^= s << 25;
+        s ^= s >> 27;
+        return s * 2685821657736338717ULL;
+    }
+    int below(int n) { return next() % n; }
+};
+
+struct filter
+{
+    int clues_lo, clues_hi, rating_lo, rating_hi;
+    uint32_t cls;
+    bool any_class, geo;
+};
+
+/* first group not before (clues, rating, cls) */
+static size_t lower(int clues, int rating, uint32_t cls)
+{
+    size_t lo = 0, hi = db.header->groups;
+    while (lo < hi) {
+        size_t mid = (lo+hi) / 2;
+        const corpus_group &g = db.group[mid];
+        if (corpus_less(g.clues, g.rating, g.cls, clues, rating, cls))
+            lo = mid+1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+struct run
+{
+    uint64_t begin, end;
+};
+
+/* the runs of entries matching f */
+static void matching(const filter &f, std::vector<run> &runs)
+{
+    runs.clear();
+    for (int c=f.clues_lo; c<=f.clues_hi; c++) {
+        if (f.any_class) {
+            size_t a = lower(c, f.rating_lo, 0);
+            size_t b = lower(c, f.rating_hi+1, 0);
+            if (a < b)
+                runs.push_back(run{db.group[a].begin, db.group[b-1].end});
+        } else {
+            for (int r=f.rating_lo; r<=f.rating_hi; r++) {
+                size_t a = lower(c, r, f.cls);
+                if (a < db.header->groups && db.group[a].clues == c &&
+                    db.group[a].rating == r && db.group[a].cls == f.cls)
+                    runs.push_back(run{db.group[a].begin, db.group[a].end});
+            }
+        }
+    }
+}
+
+/* a uniformly random entry of the runs, or -1 */
+static int64_t pick(const std::vector<run> &runs, rng &g)
+{
+    uint64_t total = 0;
+    for (size_t k=0; k<runs.size(); k++)
+        total += runs[k].end - runs[k].begin;
+    if (!total)
+        return -1;
+    uint64_t x = g.next() % total;
+    for (size_t k=0; ; k++) {
+        if (x < runs[k].end - runs[k].begin)
+            return runs[k].begin + x;
+        x -= runs[k].end - runs[k].begin;
+    }
+}
+
+static void shuffle(int *a, int n, rng &g)
+{
+    for (int i=0; i<n; i++)
+        a[i] = i;
+    for (int i=n-1; i>0; i--)
+        std::swap(a[i], a[g.below(i+1)]);
+}
+
+/*
+ * the entry as solution and puzzle strings, digits relabelled and with
+ * geo the cells moved: bands and rows within bands, stacks and columns
+ * within stacks permuted, and transposed half of the time
+ */
+static void transform(const corpus_entry &e, bool geo, rng &g,
+                      char *puzzle, char *minimal)
+{
+    int digit[9], pos[81];
+    shuffle(digit, 9, g);
+    for (int i=0; i<81; i++)
+        pos[i] = i;
+    if (geo) {
+        int map[2][9];
+        for (int d=0; d<2; d++) {
+            int outer[3], inner[3];
+            shuffle(outer, 3, g);
+            for (int b=0; b<3; b++) {
+                shuffle(inner, 3, g);
+                for (int k=0; k<3; k++)
+                    map[d][b*3+k] = outer[b]*3 + inner[k];
+            }
+        }
+        bool t = g.below(2);
+        for (int i=0; i<81; i++) {
+            int y = map[0][i/9], x = map[1][i%9];
+            pos[i] = t ? x*9+y : y*9+x;
+        }
+    }
+    for (int i=0; i<81; i++) {
+        char c = '1' + digit[corpus_cell(e, i)-1];
+        puzzle[pos[i]] = c;
+        minimal[pos[i]] = corpus_clue(e, i) ? c : '.';
+    }
+    puzzle[81] = minimal[81] = 0;
+}
+
+/* "n" or "lo-hi" into lo, hi; false if malformed */
+static bool parse_range(const char *s, int &lo, int &hi)
+{
+    char *end;
+    lo = hi = std::strtol(s, &end, 10);
+    if (end == s)
+        return false;
+    if (*end == '-') {
+        s = end+1;
+        hi = std::strtol(s, &end, 10);
+        if (end == s)
+            return false;
+    }
+    return (*end == '&' || !*end) && lo <= hi;
+}
+
+static bool parse_query(const char *q, filter &f)
+{
+    f.clues_lo = 0;
+    f.clues_hi = 81;
+    f.rating_lo = 0;
+    f.rating_hi = 15;
+    f.any_class = true;
+    f.geo = false;
+    while (q && *q) {
+        if (std::strncmp(q, "clues=", 6) == 0) {
+            if (!parse_range(q+6, f.clues_lo, f.clues_hi))
+                return false;
+        } else if (std::strncmp(q, "rating=", 7) == 0) {
+            if (!parse_range(q+7, f.rating_lo, f.rating_hi))
+                return false;
+        } else if (std::strncmp(q, "class=", 6) == 0) {
+            int lo, hi;
+            if (!parse_range(q+6, lo, hi) || lo != hi || lo < 0)
+                return false;
+            f.cls = lo;
+            f.any_class = false;
+        } else if (std::strncmp(q, "geo=", 4) == 0) {
+            f.geo = q[4] == '1';
+        } else {
+            return false;
+        }
+        q = std::strchr(q, '&');
+        if (q)
+            q++;
+    }
+    f.clues_lo = std::max(f.clues_lo, 0);
+    f.clues_hi = std::min(f.clues_hi, 81);
+    f.rating_lo = std::max(f.rating_lo, 0);
+    f.rating_hi = std::min(f.rating_hi, 15);
+    return true;
+}
+
+static void reply(int fd, const char *status, const std::string &body)
+{
+    char head[256];
+    int n = std::snprintf(head, sizeof(head),
+                          "HTTP/1.1 %s\r\n"
+                          "Content-Type: application/json\r\n"
+                          "Content-Length: %zu\r\n"
+                          "Access-Control-Allow-Origin: *\r\n"
+                          "Connection: close\r\n\r\n", status, body.size());
+    std::string out(head, n);
+    out += body;
+    for (size_t done=0; done<out.size(); ) {
+        ssize_t w = send(fd, out.data()+done, out.size()-done, MSG_NOSIGNAL);
+        if (w <= 0)
+            break;
+        done += w;
+    }
+}
+
+static std::string stats()
+{
+    std::string s = "{\"count\": " + std::to_string(db.header->count) + ", \"groups\": [";
+    for (uint32_t k=0; k<db.header->groups; k++) {
+        const corpus_group &g = db.group[k];
+        s += k ? ", [" : "[";
+        s += std::to_string(g.clues) + ", " + std::to_string(g.rating) + ", ";
+        s += g.cls == CORPUS_NOCLASS ? "null" : std::to_string(g.cls);
+        s += ", " + std::to_string(g.end - g.begin) + "]";
+    }
+    return s + "]}\n";
+}
+
+static void handle(int fd, rng &g, std::vector<run> &runs)
+{
+    char req[4096];
+    size_t n = 0;
+    while (n < sizeof(req)-1) {
+        ssize_t r = recv(fd, req+n, sizeof(req)-1-n, 0);
+        if (r <= 0)
+            break;
+        n += r;
+        req[n] = 0;
+        if (std::strstr(req, "\r\n\r\n") || std::strstr(req, "\n\n"))
+            break;
+    }
+    req[n] = 0;
+    char *sp = 0;
+    if (std::strncmp(req, "GET ", 4) != 0 || !(sp = std::strchr(req+4, ' '))) {
+        reply(fd, "400 Bad Request", "{\"error\": \"bad request\"}\n");
+        return;
+    }
+    *sp = 0;
+    char *path = req+4, *query = std::strchr(path, '?');
+    if (query)
+        *query++ = 0;
+
+    if (std::strcmp(path, "/stats") == 0) {
+        reply(fd, "200 OK", stats());
+        return;
+    }
+    filter f;
+    if (std::strcmp(path, "/puzzle") != 0) {
+        reply(fd, "404 Not Found", "{\"error\": \"unknown path\"}\n");
+        return;
+    }
+    if (!parse_query(query, f)) {
+        reply(fd, "400 Bad Request", "{\"error\": \"bad filter\"}\n");
+        return;
+    }
+    matching(f, runs);
+    int64_t i = pick(runs, g);
+    if (i < 0) {
+        reply(fd, "404 Not Found", "{\"error\": \"no matching puzzle\"}\n");
+        return;
+    }
+    const corpus_entry &e = db.entry[i];
+    char puzzle[82], minimal[82], body[384];
+    transform(e, f.geo, g, puzzle, minimal);
+    char cls[16];
+    if (e.cls == CORPUS_NOCLASS || f.geo)
+        std::strcpy(cls, "null");
+    else
+        std::snprintf(cls, sizeof(cls), "%u", e.cls);
+    std::snprintf(body, sizeof(body),
+                  "{\"puzzle\": \"%s\", \"minimal\": \"%s\", "
+                  "\"clues\": %d, \"rating\": %d, \"class\": %s}\n",
+                  puzzle, minimal, e.clues, e.rating, cls);
+    reply(fd, "200 OK", body);
+}
+
+static void worker(int listen_fd, int id)
+{
+    rng g;
+    g.s = std::chrono::steady_clock::now().time_since_epoch().count()
+          ^ (uint64_t)(id+1) * 0x9e3779b97f4a7c15ULL;
+    if (!g.s)
+        g.s = 1;
+    std::vector<run> runs;
+    for (;;) {
+        int fd = accept(listen_fd, 0, 0);
+        if (fd < 0)
+            continue;
+        struct timeval tv = {2, 0};
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        handle(fd, g, runs);
+        close(fd);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *file = 0, *sock_path = 0;
+    int port = 8080, threads = std::thread::hardware_concurrency();
+
+    for (int k=1; k<argc; k++) {
+        if (argv[k][0] == '-' && argv[k][1] == 'p')
+            port = std::atoi(argv[k]+2);
+        else if (argv[k][0] == '-' && argv[k][1] == 'j')
+            threads = std::atoi(argv[k]+2);
+        else if (std::strcmp(argv[k], "-u") == 0 && k+1 < argc)
+            sock_path = argv[++k];
+        else if (argv[k][0] != '-')
+            file = argv[k];
+        else
+            file = 0, k = argc;
+    }
+    if (!file) {
+        std::cerr << "Usage: " << argv[0] << " [-p8080 | -u path] [-j4] file.corpus"
+                  << std::endl;
+        return 1;
+    }
+    if (threads < 1)
+        threads = 1;
+    if (!corpus_map(db, file)) {
+        std::cerr << "error: can't map corpus " << file << std::endl;
+        return 1;
+    }
+
+    int fd;
+    if (sock_path) {
+        struct sockaddr_un a;
+        std::memset(&a, 0, sizeof(a));
+        a.sun_family = AF_UNIX;
+        if (std::strlen(sock_path) >= sizeof(a.sun_path)) {
+            std::cerr << "error: socket path too long" << std::endl;
+            return 1;
+        }
+        std::strcpy(a.sun_path, sock_path);
+        unlink(sock_path);
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0 || bind(fd, (struct sockaddr *)&a, sizeof(a)) != 0) {
+            std::cerr << "error: can't bind " << sock_path << std::endl;
+            return 1;
+        }
+    } else {
+        struct sockaddr_in a;
+        std::memset(&a, 0, sizeof(a));
+        a.sin_family = AF_INET;
+        a.sin_port = htons(port);
+        a.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        int on = 1;
+        if (fd >= 0)
+            setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (fd < 0 || bind(fd, (struct sockaddr *)&a, sizeof(a)) != 0) {
+            std::cerr << "error: can't bind 127.0.0.1:" << port << std::endl;
+            return 1;
+        }
+    }
+    if (listen(fd, 128) != 0) {
+        std::cerr << "error: can't listen" << std::endl;
+        return 1;
+    }
+    std::signal(SIGPIPE, SIG_IGN);
+    std::cerr << db.header->count << " puzzles in " << db.header->groups
+              << " groups, " << threads << " workers" << std::endl;
+
+    std::vector<std::thread> pool;
+    for (int t=0; t<threads; t++)
+        pool.push_back(std::thread(worker, fd, t));
+    for (size_t t=0; t<pool.size(); t++)
+        pool[t].join();
+    return 0;
+}
@@ -5,7 +5,11 @@
 // DOS/Windows-executable is at : http://magictour.free.fr/suexco.exe
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
+#include <math.h>
+#include <pthread.h>
+#include <signal.h>
 #define M 8 // change this for larger grids. Use symbols as in L[] below
 #define M2 M*M
 #define M4 M2*M2
@@ -27,7 +31,54 @@ double xx,yy;
 char L[66]=".123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz#*~";
 char*Arg;
  FILE *file;
+// the uncovered columns by their number of live rows: bit c of B[v] is set
+// if column c is uncovered and V[c]==v, Bn[v] counts them. kept up to date
+// wherever Uc or V changes, so the search finds its column without a scan
+#define BW (4*M4/64+1)
+unsigned long long B[M2+2][BW],b;int Bn[M2+2],w,bw;
+#define BIN(c) (B[V[c]][(c)>>6]|=1ULL<<((c)&63),Bn[V[c]]++)
+#define BOUT(c) (B[V[c]][(c)>>6]^=1ULL<<((c)&63),Bn[V[c]]--)
+#define BDEC(c) (BOUT(c),V[c]--,BIN(c))
+#define BINC(c) (BOUT(c),V[c]++,BIN(c))
 int shuffle();
+void estimate();
+void exact();
+
+// estimation mode: Knuth's random probes. a probe walks down the search tree
+// picking the most constrained column like the search does, but follows one
+// random row; the product of the branching factors on the way is an unbiased
+// estimate of the number of solutions if it ends in one, 0 otherwise.
+// the probes run on jt threads, each with its own MWC stream
+ int e=0,jt=1;double *Est;
+typedef struct{int id,*Ur,*Uc,*V;unsigned zr,wr;}probe_t;
+
+// exact mode: counts the solutions without enumerating them, with the
+// component caching of #SAT counters. the uncovered columns fall apart
+// into components that share no live row, and the count is the product
+// of the counts of the components. the live rows of a component are the
+// ones inside it, so its count only depends on its set of columns and
+// is cached under that bit set, across the puzzles of a file too. the
+// cache is a hash table of xm MB: a new entry goes to the first empty of
+// its 4 slots or else replaces the smallest component there. counts are
+// 128 bit, enough for any 9*9 board. larger boards can go past that, so
+// sums and products saturate at XMAX and xsat marks a count that did
+typedef unsigned __int128 u128;u128 xt;char *u128s(u128 t);int xsat;
+#define XMAX (~(u128)0)
+ int xm=0,xw,xe,*Xq,*Xr,xr,*Xc,xc;unsigned long long *Xt,Xn,*Xs,*Xk,*Xv,xv;long long xhits,xcomp;
+
+// limits of one puzzle: vmax nodes, smax solutions, a deadline of dl ms
+// wall clock and SIGINT/SIGTERM. the search checks stop on every node and
+// the clock every 1024 nodes; a stopped puzzle is reported as
+// "incomplete(why)" with the solutions and nodes it got to, so the count
+// is a lower bound. why is solutions, nodes, deadline or cancelled; this
+// prefix replaces the bare + (smax) and - (vmax) of older versions. after
+// a signal the current puzzle is reported and the program exits
+ volatile sig_atomic_t stop=0;long long dl=0,dl0;char*why;
+long long msec(){struct timespec ts;clock_gettime(CLOCK_MONOTONIC,&ts);
+  return ts.tv_sec*1000LL+ts.tv_nsec/1000000;}
+void cancel(int sig){(void)sig;stop=1;}
+int expired(){if(stop){why="cancelled";return 1;}
+  if(dl && msec()>=dl0+dl){why="deadline";return 1;}return 0;}
 
 int main(int argc,char*argv[]){ 
   if(argc<2){m5:printf("\nusage:suexco file [nn] [p] [smax] [vmax] \n\n");
@@ -36,28 +87,38 @@ int main(int argc,char*argv[]){
   printf(" ignored\n\n");
   printf("n3:n=3,9*9-sudoku  (default:guess the size)\n");
   printf("s47:interrupt after 47 solutions   (default=999)\n");
-  printf("v500000:interrupt after 500000 nodes (default=4000000)\n");
+  printf("v500000:interrupt after 500000 nodes (default=4000000, oo with x)\n");
+  printf("d250:interrupt each sudoku after 250 ms (default=oo)\n");
   printf("r99999: random restart after 99999 nodes (default=oo)\n");
   printf("r1: randomly shuffle the exact-cover matrix (default=don't)\n");
   printf("r17: random choice on ties (default:first match)\n");
   printf("r18: alternate on ties\n");
   printf("p:print solutions  p=6,only counts(default=don't)\n");
-  printf("q50:prunes valid placements (32<i<65) with probability 50/1.28 % \n");
-  printf("t1000:same calculation 1000-fold for benchmarking (default=1)\n");
-  exit(1);}vmax=4000000;smax=999;tries=1;p=0;q=0;
+  printf("e10000:estimate the number of solutions with 10000 random probes\n");
+  printf("j4:run the probes on 4 threads (default=1)\n");
+  printf("x256:count exactly, caching components in 256 MB (default=don't)\n");
+  printf("t1000:same calculation 1000-fold for benchmarking (default=1)\n\n");
+  printf("a sudoku stopped by s, v, d or a signal gets the prefix\n");
+  printf("incomplete(solutions|nodes|deadline|cancelled) instead of + or -\n");
+  exit(1);}vmax=-1;smax=999;tries=1;p=0;
   for(k=2;k<argc;k++){Arg=argv[k]+1;
   if(argv[k][0]=='n')sscanf(Arg,"%i",&N);
   if(argv[k][0]=='s')sscanf(Arg,"%Li",&smax);
   if(argv[k][0]=='p'){sscanf(Arg,"%i",&p);if(p==0)p=1;}
   if(argv[k][0]=='r')sscanf(Arg,"%i",&rnd);
-  if(argv[k][0]=='q')sscanf(Arg,"%i",&q);
+  if(argv[k][0]=='e')sscanf(Arg,"%i",&e);
+  if(argv[k][0]=='j')sscanf(Arg,"%i",&jt);
+  if(argv[k][0]=='x'){xm=256;sscanf(Arg,"%i",&xm);if(xm<1)xm=1;}
   if(argv[k][0]=='v')sscanf(Arg,"%Li",&vmax);
+  if(argv[k][0]=='d')sscanf(Arg,"%Li",&dl);
   if(argv[k][0]=='c')nocheck=1;
   if(argv[k][0]=='t')sscanf(Arg,"%i",&tries);}
 
+ if(vmax<0)vmax=xm>0?~0ULL>>1:4000000;
  x=7;zr^=x;wr+=x;
  if(rnd<999){zr^=rnd;wr+=rnd;for(i=1;i<rnd;i++)MWC;}
-if(q){vmax=99999999;smax=99999999;}
+if(jt<1)jt=1;
+signal(SIGINT,cancel);signal(SIGTERM,cancel);
 
  if(N==0){if((file=fopen(argv[1],"rb"))==NULL)
     {fclose(file);printf("\nfile-error\n\n");goto m5;}
@@ -77,7 +138,7 @@ m6:clues=0;t1=clock();i=0;for(x=1;x<=N2;x++)for(y=1;y<=N2;y++){
 
 // for(x=1;x<=N2;x++){for(y=1;y<=N2;y++)printf("%i",A0[x][y]);printf("\n");}
 
-if(p<8){for(i=0;i<=N4;i++)Node[i]=0;}tnodes=0;
+if(p<8){for(i=0;i<=N4;i++)Node[i]=0;}tnodes=0;why=0;dl0=msec();xt=xhits=xcomp=0;xsat=0;
 
 for(try=1;try<=tries;try++){ // you can do multiple tries for benchmarking here
 
@@ -98,27 +159,34 @@ solutions=0;
        for(k=1;k<=Rows[c1];k++){r1=Row[c1][k];Ur[r1]++;}}}
 if(rnd>0 && rnd!=17 &&rnd!=18)shuffle();
  for(c=1;c<=m;c++){V[c]=0;for(r=1;r<=Rows[c];r++)if(Ur[Row[c][r]]==0)V[c]++;}
+if(e>0){estimate();goto next_try;}
+if(xm>0){exact();goto next_try;}
+bw=m/64+1;for(x=0;x<=N2;x++){Bn[x]=0;for(w=0;w<bw;w++)B[x][w]=0;}
+ for(c=1;c<=m;c++)if(!Uc[c])BIN(c);
 
 //---------walk through the searchtree now------------------
    i=clues;nodes=0;m0=0;m1=0;gu=0;solutions=0;
 m2:i++;I[i]=0;min=n+1;if(i>N4 || m0)goto m4;
    if(m1){C[i]=m1;goto m3;}
-   for(c=1;c<=m;c++)if(!Uc[c]){if(V[c]<=min)c1=c;
-     if(V[c]<min){min=V[c];C[i]=c;if(min<2)goto m3;}}
+// the first column with V<2, else the first one with the fewest rows
+   if(Bn[0]+Bn[1]){for(w=0;!(b=B[0][w]|B[1][w]);w++);C[i]=w*64+__builtin_ctzll(b);goto m3;}
+   for(min=2;min<N2 && !Bn[min];min++);
+   for(w=0;!(b=B[min][w]);w++);C[i]=w*64+__builtin_ctzll(b);
    gu++;if(min>2)goto m3;
 
-if((rnd&255)==18)if(nodes&1){c=m+1;m3v:c--;if(Uc[c] || V[c]!=2)goto m3v;C[i]=c;}
+// V==2 ties: r18 takes the last one on every other node, r17 the first
+// one from a random column on
+if((rnd&255)==18)if(nodes&1){for(w=bw-1;!(b=B[2][w]);w--);C[i]=w*64+63-__builtin_clzll(b);}
 
 if((rnd&255)==17){mr5:c1=MWC&Mc[N];if(c1>=m)goto mr5;c1++;
-   for(c=c1;c<=m;c++)if(!Uc[c])if(V[c]==2){C[i]=c;goto m3;}
-   for(c=1;c<c1;c++)if(!Uc[c])if(V[c]==2){C[i]=c;goto m3;}}
+   w=c1>>6;b=B[2][w]&(~0ULL<<(c1&63));
+   while(!b){w++;if(w==bw)w=0;b=B[2][w];}
+   C[i]=w*64+__builtin_ctzll(b);}
 
 m3:c=C[i];I[i]++;if(I[i]>Rows[c])goto m4;
    r=Row[c][I[i]];if(Ur[r])goto m3;m0=0;m1=0;
 
 
-if(q>0 && i>32 && i<65)if((MWC&127)<q)goto m3;
-//if(q>0 && i>q)goto m3; //##q
 //if(i==37 && (MWC&1023)>1)goto m3;
 //if(i==48 && (MWC&1023)>1)goto m3;
 
@@ -129,32 +197,37 @@ if(q>0 && i>32 && i<65)if((MWC&127)<q)goto m3;
 }}
 
 
-   for(j=1;j<=Cols[r];j++){c1=Col[r][j];Uc[c1]++;}
+   for(j=1;j<=Cols[r];j++){c1=Col[r][j];if(!Uc[c1])BOUT(c1);Uc[c1]++;}
    for(j=1;j<=Cols[r];j++){c1=Col[r][j];
       for(k=1;k<=Rows[c1];k++){r1=Row[c1][k];Ur[r1]++;if(Ur[r1]==1)
-         for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];V[c2]--;
-            if(Uc[c2]+V[c2]<1)m0=c2;if(Uc[c2]==0 && V[c2]<2)m1=c2;}}}
+         for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];if(Uc[c2]){V[c2]--;continue;}BDEC(c2);
+            if(V[c2]<1)m0=c2;if(V[c2]<2)m1=c2;}}}
    Node[i]++;tnodes++;nodes++;if(rnd>99 && nodes>rnd){printf("restart\n");goto restart;}
     if(i==N4)solutions++;
-    if(solutions>=smax){if(try==1)printf("+");goto next_try;}
-   if(tnodes>vmax){if(try==1)printf("-");goto next_try;}
+    if(solutions>=smax){why="solutions";goto next_try;}
+   if(tnodes>vmax){why="nodes";goto next_try;}
+   if(stop || (!(tnodes&1023) && expired()))goto next_try;
    goto m2;
 m4:i--;c=C[i];r=Row[c][I[i]];if(i==clues)goto next_try;
-   for(j=1;j<=Cols[r];j++){c1=Col[r][j];Uc[c1]--;
+   for(j=1;j<=Cols[r];j++){c1=Col[r][j];Uc[c1]--;if(!Uc[c1])BIN(c1);
       for(k=1;k<=Rows[c1];k++){r1=Row[c1][k];Ur[r1]--;
-         if(Ur[r1]==0)for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];V[c2]++;}}}
+         if(Ur[r1]==0)for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];if(Uc[c2])V[c2]++;else BINC(c2);}}}
    if(p){j=N2;k=N4;x=(r-1)/k+1;y=((r-1)%k)/j+1;s=(r-1)%j+1;A[x][y]=0;}
    if(i>clues)goto m3;
-next_try:;}
+next_try:if(stop)why="cancelled";if(stop || (dl && msec()>=dl0+dl))break;}
 time1=clock();x=time1-time0;if(x<0)x+=65536;if(x>65535)x-=65536;
 time0=time1;
 
-if(q){xx=128;yy=128-q;xx=xx/yy;yy=solutions;for(i=1;i<33;i++)yy=yy*xx;printf("clues:%i  estimated solutions:%1.2le\n",clues,yy);goto m6;}
-if(!p && tnodes<=999999){printf("%Li sol.  %6Li nodes  %i guesses  %i/91sec  %i \n",solutions,tnodes,gu,clock(),x);goto m6;}
-if(p==6){printf("%9Li\n",solutions);goto m6;}
+if(e>0)goto m8;
+if(why)printf("incomplete(%s) ",why);
+if(xm>0){if(xsat)fprintf(stderr,"warning: the count passes 2^128-1\n");
+  printf("clues:%i  solutions:%s%s  nodes:%Li  components:%Li  cache hits:%Li\n",clues,why || xsat?">=":"",u128s(xt),tnodes,xcomp,xhits);goto m8;}
+if(!p && tnodes<=999999){printf("%Li sol.  %6Li nodes  %i guesses  %i/91sec  %i \n",solutions,tnodes,gu,clock(),x);goto m8;}
+if(p==6){printf("%9Li\n",solutions);goto m8;}
 if(!p){printf("%Li sol.  %Li nodes  %i guesses  %i/91sec  %i \n",solutions,tnodes,gu,clock(),x);}
 if(p>5){x=0;for(i=1;i<=N4;i++){x+=Node[i];printf("%Li ",Node[i]);}printf("  %i\n",x);}
 
+m8:if(stop)exit(2);
 goto m6; }
 
 
@@ -181,3 +254,141 @@ for(c=1;c<=m;c++){
   for(i=1;i<=Rows[c];i++)Row[c][i]=T[i];}
 
 }
+
+
+
+// one thread of probes: k=id,id+jt,.. so the estimates don't depend on timing
+void *prober(void *arg){
+probe_t *t=arg;int i,j,k,l,c,c1,r,r1,min,d,R[M2+9],*ur=t->Ur,*uc=t->Uc,*v=t->V;
+unsigned zr=t->zr,wr=t->wr;double w;
+
+for(k=t->id;k<e;k+=jt){if(stop || (dl && msec()>=dl0+dl))break;
+  memcpy(ur,Ur,(n+1)*sizeof(int));memcpy(uc,Uc,(m+1)*sizeof(int));memcpy(v,V,(m+1)*sizeof(int));
+  w=1;c=0;
+  for(i=clues+1;i<=N4;i++){
+    min=n+1;for(c1=1;c1<=m;c1++)if(!uc[c1] && v[c1]<min){min=v[c1];c=c1;}
+    if(min==0){w=0;break;}
+    d=0;for(l=1;l<=Rows[c];l++)if(!ur[Row[c][l]])R[d++]=Row[c][l];
+    w*=d;r=R[MWC%d];
+    for(j=1;j<=Cols[r];j++)uc[Col[r][j]]++;
+    for(j=1;j<=Cols[r];j++){c1=Col[r][j];
+      for(l=1;l<=Rows[c1];l++){r1=Row[c1][l];ur[r1]++;if(ur[r1]==1)
+        for(d=1;d<=Cols[r1];d++)v[Col[r1][d]]--;}}}
+  Est[k]=w;}
+return 0;}
+
+
+
+// runs the probes and prints the running estimate with its standard error
+// after 1,2,4,.. probes and at the end
+void estimate(){
+pthread_t *th;probe_t *pt;double sum=0,sq=0,mean=0,se=0;int t,k,o=0;
+
+Est=malloc(e*sizeof(double));for(k=0;k<e;k++)Est[k]=-1;th=malloc(jt*sizeof(pthread_t));pt=malloc(jt*sizeof(probe_t));
+for(t=0;t<jt;t++){pt[t].id=t;pt[t].zr=zr^(t*0x9E3779B9u);pt[t].wr=wr+t*7919;
+  pt[t].Ur=malloc((n+1)*sizeof(int));pt[t].Uc=malloc((m+1)*sizeof(int));pt[t].V=malloc((m+1)*sizeof(int));
+  pthread_create(&th[t],0,prober,&pt[t]);}
+for(t=0;t<jt;t++){pthread_join(th[t],0);free(pt[t].Ur);free(pt[t].Uc);free(pt[t].V);}
+// probes cut off by the deadline or a signal are left at -1 and skipped
+for(k=0;k<e;k++)if(Est[k]>=0){o++;sum+=Est[k];sq+=Est[k]*Est[k];mean=sum/o;
+  se=o>1?sqrt((sq/o-mean*mean)/(o-1)):0;if(se!=se)se=0;
+  if((o&(o-1))==0)printf("  %9i probes  %1.3le  se:%1.2le\n",o,mean,se);}
+if(o<e)why=stop?"cancelled":"deadline";
+if(why)printf("incomplete(%s) ",why);
+printf("clues:%i  estimated solutions:%1.3le  se:%1.2le  probes:%i\n",clues,mean,se,o);
+free(Est);free(th);free(pt);
+}
+
+
+
+// cover and uncover row r, keeping Uc, Ur and V like the search. cover
+// puts the uncovered columns left with less than 2 live rows on Xc
+void xcover(int r){int j,k,l,c1,c2,r1;
+for(j=1;j<=Cols[r];j++)Uc[Col[r][j]]++;
+for(j=1;j<=Cols[r];j++){c1=Col[r][j];
+  for(k=1;k<=Rows[c1];k++){r1=Row[c1][k];if(++Ur[r1]==1)
+    for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];if(--V[c2]<2 && !Uc[c2])Xc[xc++]=c2;}}}}
+
+void xuncover(int r){int j,k,l,c1,r1;
+for(j=1;j<=Cols[r];j++){c1=Col[r][j];Uc[c1]--;
+  for(k=1;k<=Rows[c1];k++){r1=Row[c1][k];if(--Ur[r1]==0)
+    for(l=1;l<=Cols[r1];l++)V[Col[r1][l]]++;}}}
+
+// the limits of the search: vmax nodes, the deadline and signals
+int xstop(){if(why)return 1;if(tnodes>vmax){why="nodes";return 1;}
+  return (stop || !(tnodes&1023)) && expired();}
+
+u128 xbranch(unsigned long long *S,int d);
+
+// the count of the columns in Xs[d]: the columns on Xc with one live row
+// are covered first (the rows go on Xr and are uncovered at the end), then
+// the rest is split into components, each one collected in Xk[d] by a
+// walk over the live rows (Xv marks the rows seen), and the count is the
+// product of theirs. 0 as soon as a column has no live row or a component
+// no solution. below the top only a rest of at most m/4 columns is walked:
+// a 9*9 board hardly ever falls apart with more than 100 of its 324
+// columns left, and there the walk costs more than the search
+u128 xcount(int d){
+unsigned long long *T=Xs+(long long)d*xw,*K=Xk+(long long)d*xw;
+int c,c1,c2,r,r1,k,l,w,q0,q1,x0=xr,s=0;u128 t=1,u;
+while(xc){c=Xc[--xc];if(Uc[c])continue;
+  if(!V[c]){t=0;xc=0;break;}
+  for(k=1;Ur[r=Row[c][k]];k++);
+  xcover(r);Xr[xr++]=r;tnodes++;
+  for(k=1;k<=Cols[r];k++){c1=Col[r][k];T[c1>>6]&=~(1ULL<<(c1&63));}}
+for(w=0;w<xw;w++)s+=__builtin_popcountll(T[w]);
+if(d && s>m/4){if(s && t){memcpy(K,T,xw*8);xcomp++;t=xbranch(K,d+1);}}
+else{xv++;
+for(w=0;w<xw && t;w++)while(T[w] && t){
+  c=w*64+__builtin_ctzll(T[w]);T[w]&=T[w]-1;
+  memset(K,0,xw*8);K[w]|=1ULL<<(c&63);Xq[0]=c;q0=0;q1=1;
+  while(q0<q1){c=Xq[q0++];
+    for(k=1;k<=Rows[c];k++){r1=Row[c][k];if(Ur[r1] || Xv[r1]==xv)continue;Xv[r1]=xv;
+      for(l=1;l<=Cols[r1];l++){c2=Col[r1][l];if(T[c2>>6]>>(c2&63)&1){
+        T[c2>>6]^=1ULL<<(c2&63);K[c2>>6]|=1ULL<<(c2&63);Xq[q1++]=c2;}}}}
+  xcomp++;u=xbranch(K,d+1);if(u && t>XMAX/u){t=XMAX;xsat=1;}else t*=u;}}
+while(xr>x0)xuncover(Xr[--xr]);
+return t;}
+
+// the count of component S at depth d, whose columns have 2 or more live
+// rows: from the cache, else the sum over the live rows of its column
+// with the fewest of them of the count of the rest. nothing is cached
+// once stopped
+u128 xbranch(unsigned long long *S,int d){
+unsigned long long h,*e,*f=0,*T=Xs+(long long)d*xw;
+int c=0,c1,r,j,k,w,min=n+1,s=0;u128 t=0,u;
+for(w=0;w<xw;w++)s+=__builtin_popcountll(S[w]);
+h=s;for(w=0;w<xw;w++)h=(h^S[w])*0x100000001B3ULL;h^=h>>29;
+for(k=0;k<4;k++){e=Xt+((h+k)&(Xn-1))*xe;
+  if(e[0]==(unsigned long long)s && !memcmp(e+1,S,xw*8)){xhits++;t=(u128)e[xw+2]<<64|e[xw+1];
+    xsat|=t==XMAX;return t;}
+  if(!f || e[0]<f[0])f=e;}
+for(w=0;w<xw;w++)for(h=S[w];h;h&=h-1){c1=w*64+__builtin_ctzll(h);if(V[c1]<min){min=V[c1];c=c1;}}
+for(j=1;j<=Rows[c] && !why;j++){r=Row[c][j];if(Ur[r])continue;
+  xc=0;xcover(r);tnodes++;
+  memcpy(T,S,xw*8);for(k=1;k<=Cols[r];k++){c1=Col[r][k];T[c1>>6]&=~(1ULL<<(c1&63));}
+  if(!xstop()){u=xcount(d);t+=u;if(t<u){t=XMAX;xsat=1;}}
+  xuncover(r);}
+if(!why){f[0]=s;memcpy(f+1,S,xw*8);f[xw+1]=(unsigned long long)t;f[xw+2]=(unsigned long long)(t>>64);}
+return t;}
+
+
+
+// counts the solutions of the current puzzle exactly into xt. the cache is
+// cleared only when r1 shuffles the matrix, which renumbers the columns.
+// there is no node limit unless v is given; a stopped count only has the
+// branches it finished and is printed as a lower bound
+void exact(){int c;
+if(!Xt){xw=m/64+1;xe=xw+3;
+  for(Xn=1;Xn*2*xe*8<=xm*1048576ULL;Xn*=2);
+  Xt=calloc(Xn,xe*8);Xs=malloc((N4+2)*xw*8);Xk=malloc((N4+2)*xw*8);Xq=malloc((m+1)*sizeof(int));Xr=malloc((N4+1)*sizeof(int));Xc=malloc((2*m+1)*sizeof(int));Xv=calloc(n+1,8);
+  if(!Xt || !Xs || !Xk || !Xq || !Xr || !Xc || !Xv){printf("\nout of memory\n\n");exit(1);}}
+else if(rnd>0 && rnd!=17 && rnd!=18)memset(Xt,0,Xn*xe*8);
+memset(Xs,0,xw*8);xr=xc=0;
+for(c=1;c<=m;c++)if(!Uc[c]){Xs[c>>6]|=1ULL<<(c&63);if(V[c]<2)Xc[xc++]=c;}
+xt=xcount(0);
+}
+
+// t in decimal
+char *u128s(u128 t){static char s[48];char *a=s+47;
+*a=0;do{*--a='0'+(int)(t%10);t/=10;}while(t);return a;}
@@ -0,0 +1,625 @@
+/*
+ * Find the unavoidable sets of a complete Sudoku grid and search for
+ * all puzzles with a given number of clues that have this grid as
+ * their unique solution.
+ *
+ * An unavoidable set is a set of cells of the grid whose values can
+ * be permuted to give another valid grid, so every puzzle for the grid
+ * needs a clue in it. A puzzle is therefore a hitting set of all the
+ * unavoidable sets; we collect a bank of small ones, enumerate the
+ * clue placements that hit all of them, and check each of these with
+ * a uniqueness solver. A solver failure yields a second solution, and
+ * the cells where it differs from the grid are a new unavoidable set.
+ *
+ * Usage:
+ * ./unavoidable [-n17] [-j8] [-1] [-s] file
+ *
+ * Compile (example):
+ * g++ -O3 -march=native -pthread unavoidable.cc -o unavoidable
+ */
+
+#include <algorithm>
+#include <vector>
+#include <string>
+#include <iostream>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <climits>
+#include <stdint.h>
+
+/*
+ * set of cells 0..80 as two 64 bit words
+ */
+struct cellset
+{
+    uint64_t lo, hi;
+    cellset() : lo(0), hi(0) {}
+    cellset(uint64_t l, uint64_t h) : lo(l), hi(h) {}
+    static cellset cell(int i) {
+        return i < 64 ? cellset(1ULL<<i, 0) : cellset(0, 1ULL<<(i-64));
+    }
+    bool empty() const { return !(lo | hi); }
+    int size() const { return __builtin_popcountll(lo) + __builtin_popcountll(hi); }
+    bool has(int i) const { return i < 64 ? lo>>i & 1 : hi>>(i-64) & 1; }
+    /* lowest cell, the set must not be empty */
+    int first() const { return lo ? __builtin_ctzll(lo) : 64+__builtin_ctzll(hi); }
+    cellset operator&(const cellset &o) const { return cellset(lo&o.lo, hi&o.hi); }
+    cellset operator|(const cellset &o) const { return cellset(lo|o.lo, hi|o.hi); }
+    cellset operator~() const { return cellset(~lo, ~hi & 0x1ffff); }
+    bool operator==(const cellset &o) const { return lo==o.lo && hi==o.hi; }
+    bool operator<(const cellset &o) const {
+        int a = size(), b = o.size();
+        return a != b ? a < b : hi != o.hi ? hi < o.hi : lo < o.lo;
+    }
+    bool subset_of(const cellset &o) const {
+        return !(lo & ~o.lo) && !(hi & ~o.hi);
+    }
+};
+
+/* the 27 units (rows, columns, boxes), the 3 units of each cell and
+ * its 20 peers */
+static int unit[27][9], units_of[81][3], peers[81][20];
+
+static void init_units()
+{
+    for (int i=0; i<81; i++) {
+        int r = i/9, c = i%9, b = (r/3)*3 + c/3;
+        unit[r][c] = i;
+        unit[9+c][r] = i;
+        unit[18+b][(r%3)*3 + c%3] = i;
+        units_of[i][0] = r;
+        units_of[i][1] = 9+c;
+        units_of[i][2] = 18+b;
+    }
+    for (int i=0; i<81; i++) {
+        int n = 0;
+        for (int j=0; j<81; j++)
+            if (j != i && (j/9 == i/9 || j%9 == i%9 ||
+                           ((j/27) == (i/27) && (j%9)/3 == (i%9)/3)))
+                peers[i][n++] = j;
+    }
+}
+
+/*
+ * uniqueness solver: candidate bitmasks with naked and hidden single
+ * propagation, branching on the cell with the fewest candidates and
+ * trying the grid's value last. Counts solutions up to a limit and
+ * keeps the first one that differs from the grid; with collect set,
+ * every such solution is added to it as an unavoidable set.
+ */
+struct solver
+{
+    struct state {
+        short cand[81];
+        int left;
+    };
+
+    const int *grid;
+    int limit, count;
+    int alt[81];
+    bool have_alt;
+    /* the clues are known to agree with the grid */
+    bool grid_ok;
+    std::vector<cellset> *collect;
+
+    solver(const int *g) : grid(g), grid_ok(false), collect(0) {}
+
+    bool assign(state &st, int c, int m) {
+        int other = st.cand[c] & ~m;
+        for (; other; other &= other-1)
+            if (!eliminate(st, c, other & -other))
+                return false;
+        return true;
+    }
+
+    bool eliminate(state &st, int c, int m) {
+        if (!(st.cand[c] & m))
+            return true;
+        st.cand[c] &= ~m;
+        int left = st.cand[c];
+        if (!left)
+            return false;
+        if (!(left & (left-1))) {
+            /* naked single: remove it from the peers */
+            st.left--;
+            for (int k=0; k<20; k++)
+                if (!eliminate(st, peers[c][k], left))
+                    return false;
+        }
+        /* hidden single: m has one place left in a unit of c */
+        for (int u=0; u<3; u++) {
+            const int *cells = unit[units_of[c][u]];
+            int place = -1, n = 0;
+            for (int k=0; k<9 && n<2; k++)
+                if (st.cand[cells[k]] & m) {
+                    place = cells[k];
+                    n++;
+                }
+            if (n == 0)
+                return false;
+            if (n == 1 && st.cand[place] != m && !assign(st, place, m))
+                return false;
+        }
+        return true;
+    }
+
+    void search(state &st) {
+        if (st.left == 0) {
+            /* every cell decided - a solution */
+            count++;
+            int v[81];
+            for (int i=0; i<81; i++)
+                v[i] = __builtin_ctz(st.cand[i])+1;
+            if (!std::equal(v, v+81, grid)) {
+                if (collect) {
+                    cellset d;
+                    for (int i=0; i<81; i++)
+                        if (v[i] != grid[i])
+                            d = d | cellset::cell(i);
+                    collect->push_back(d);
+                }
+                if (!have_alt) {
+                    std::copy(v, v+81, alt);
+                    have_alt = true;
+                    /* two solutions, one of them the grid: nothing more to know */
+                    if (grid_ok && !collect)
+                        count = limit;
+                }
+            }
+            return;
+        }
+        int best = -1, bestn = 10;
+        for (int i=0; i<81; i++) {
+            int n = __builtin_popcount(st.cand[i]);
+            if (n > 1 && n < bestn) {
+                best = i;
+                bestn = n;
+                if (n == 2)
+                    break;
+            }
+        }
+        /* try the grid's value last, a second solution shows up sooner */
+        int g = 1<<(grid[best]-1);
+        int m = st.cand[best] & ~g;
+        if (st.cand[best] & g)
+            m |= 1<<9;
+        for (; m && count < limit; m &= m-1) {
+            int d = m & -m;
+            state next = st;
+            if (assign(next, best, d == 1<<9 ? g : d))
+                search(next);
+        }
+    }
+
+    /* number of solutions of clues (0 = empty), counting at most up to limit */
+    int solve(const int *clues, int lim) {
+        limit = lim;
+        count = 0;
+        have_alt = false;
+        state st;
+        for (int i=0; i<81; i++)
+            st.cand[i] = 0777;
+        st.left = 81;
+        for (int i=0; i<81; i++)
+            if (clues[i] && !assign(st, i, 1<<(clues[i]-1)))
+                return 0;
+        search(st);
+        return count;
+    }
+
+    /* cells where the remembered second solution differs from the grid */
+    cellset diff() const {
+        cellset d;
+        for (int i=0; i<81; i++)
+            if (alt[i] != grid[i])
+                d = d | cellset::cell(i);
+        return d;
+    }
+};
+
+/*
+ * bank of unavoidable sets of one grid
+ */
+static int grid[81];
+static std::vector<cellset> bank;
+
+/*
+ * drop duplicates and sets that contain a smaller set, keep the
+ * smallest max sets.
+ */
+static void minimize_bank(size_t max)
+{
+    std::sort(bank.begin(), bank.end());
+    bank.erase(std::unique(bank.begin(), bank.end()), bank.end());
+    std::vector<cellset> kept;
+    for (size_t i=0; i<bank.size() && kept.size()<max; i++) {
+        bool minimal = true;
+        for (size_t k=0; k<kept.size() && minimal; k++)
+            if (kept[k].subset_of(bank[i]))
+                minimal = false;
+        if (minimal)
+            kept.push_back(bank[i]);
+    }
+    bank.swap(kept);
+}
+
+/*
+ * enumerate all solutions of the grid with the given cells removed,
+ * every other solution gives an unavoidable set. Without a limit: the
+ * cells of 4 digits, the largest region used, have some 10000-20000
+ * completions, and stopping early would lose sets.
+ */
+static void enum_sets(solver &s, const cellset &removed, int *puzzle)
+{
+    for (int i=0; i<81; i++)
+        puzzle[i] = removed.has(i) ? 0 : grid[i];
+    s.collect = &bank;
+    s.solve(puzzle, INT_MAX);
+    s.collect = 0;
+}
+
+static uint64_t rng_state = 0x9E3779B97F4A7C15ULL;
+
+static uint64_t rng()
+{
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 7;
+    rng_state ^= rng_state << 17;
+    return rng_state;
+}
+
+/*
+ * collect unavoidable sets: all those inside the cells of 2, 3 or 4
+ * digits and inside pairs of rows, columns or boxes of a band or
+ * stack, then random ones from the solver, shrunk by looking for a
+ * closer second solution inside the difference.
+ */
+static void find_sets(int probes, size_t max)
+{
+    solver s(grid);
+    int puzzle[81];
+
+    bank.clear();
+    /* all cells of 2, 3 or 4 digits */
+    for (int digits=1; digits<512; digits++) {
+        int k = __builtin_popcount(digits);
+        if (k < 2 || k > 4)
+            continue;
+        cellset removed;
+        for (int i=0; i<81; i++)
+            if (digits >> (grid[i]-1) & 1)
+                removed = removed | cellset::cell(i);
+        enum_sets(s, removed, puzzle);
+    }
+    /* two rows or two columns of a band or stack, and pairs of boxes in it */
+    for (int b=0; b<3; b++)
+        for (int u1=0; u1<3; u1++)
+            for (int u2=u1+1; u2<3; u2++) {
+                cellset rows, cols, boxes_r, boxes_c;
+                for (int k=0; k<9; k++) {
+                    rows = rows | cellset::cell(unit[3*b+u1][k]) |
+                        cellset::cell(unit[3*b+u2][k]);
+                    cols = cols | cellset::cell(unit[9+3*b+u1][k]) |
+                        cellset::cell(unit[9+3*b+u2][k]);
+                    boxes_r = boxes_r | cellset::cell(unit[18+3*b+u1][k]) |
+                        cellset::cell(unit[18+3*b+u2][k]);
+                    boxes_c = boxes_c | cellset::cell(unit[18+b+3*u1][k]) |
+                        cellset::cell(unit[18+b+3*u2][k]);
+                }
+                enum_sets(s, rows, puzzle);
+                enum_sets(s, cols, puzzle);
+                enum_sets(s, boxes_r, puzzle);
+                enum_sets(s, boxes_c, puzzle);
+            }
+    for (int p=0; p<probes; p++) {
+        /* keep about 40-60 random clues */
+        int keep = 40 + rng() % 21;
+        for (int i=0; i<81; i++)
+            puzzle[i] = (int)(rng() % 81) < keep ? grid[i] : 0;
+        if (s.solve(puzzle, 2) < 2 || !s.have_alt)
+            continue;
+        cellset d = s.diff();
+        /* shrink: keep the grid outside the difference and a quarter
+         * of the cells inside it, any other solution differs on fewer cells */
+        for (int tries=0; tries<8; tries++) {
+            for (int i=0; i<81; i++)
+                puzzle[i] = d.has(i) && (rng() & 3) ? 0 : grid[i];
+            if (s.solve(puzzle, 2) == 2 && s.have_alt)
+                d = s.diff();
+        }
+        bank.push_back(d);
+    }
+    minimize_bank(max);
+}
+
+/*
+ * the hitting set search
+ */
+static int target = 17;
+static bool first_only = false;
+static std::atomic<bool> done;
+static std::atomic<long long> checks;
+static std::mutex found_lock;
+static std::vector<cellset> found;
+
+struct task
+{
+    cellset clues, dead;
+    int n;
+};
+
+/*
+ * the search works on sets of unavoidable sets: word k bit b stands for
+ * sets[64*k+b]. hits[c] holds the sets that contain cell c, so the sets
+ * still unhit after a clue at c are unhit & ~hits[c].
+ */
+#define SET_WORDS 16
+#define MAX_SETS (64*SET_WORDS)
+
+struct setmask
+{
+    uint64_t w[SET_WORDS];
+};
+
+struct searcher
+{
+    /* the bank plus the sets this thread found at failed checks */
+    std::vector<cellset> sets;
+    setmask hits[81];
+    solver s;
+    int puzzle[81];
+
+    searcher() : s(grid) {
+        s.grid_ok = true;
+        std::memset(hits, 0, sizeof(hits));
+        for (size_t k=0; k<bank.size(); k++)
+            add_set(bank[k]);
+    }
+
+    void add_set(const cellset &c) {
+        size_t k = sets.size();
+        sets.push_back(c);
+        for (int i=0; i<81; i++)
+            if (c.has(i))
+                hits[i].w[k/64] |= 1ULL<<(k%64);
+    }
+
+    /* check the clues; if they are not unique, remember the new set
+     * (if there is room) and return its index in *set */
+    bool unique(const cellset &clues, int *set) {
+        checks++;
+        for (int i=0; i<81; i++)
+            puzzle[i] = clues.has(i) ? grid[i] : 0;
+        if (s.solve(puzzle, 2) == 1)
+            return true;
+        *set = -1;
+        if (!s.have_alt)
+            return false;
+        if (sets.size() < MAX_SETS) {
+            *set = sets.size();
+            add_set(s.diff());
+        }
+        return false;
+    }
+
+    void report(const cellset &clues) {
+        std::lock_guard<std::mutex> guard(found_lock);
+        found.push_back(clues);
+        if (first_only)
+            done = true;
+    }
+
+    /*
+     * cells to branch on for the given unhit sets, or an empty set if
+     * the node can be pruned: a set has no live cell left, or a greedy
+     * count of disjoint unhit sets says more than left clues are needed.
+     * We branch on the unhit set with the fewest live cells, or for the
+     * last clue on the cells that hit all of them.
+     */
+    cellset branch(const setmask &unhit, const cellset &dead, int left) {
+        cellset best, used, common = ~dead;
+        int bestn = 82, lb = 0;
+        for (int k=0; k<SET_WORDS; k++)
+            for (uint64_t b = unhit.w[k]; b; b &= b-1) {
+                cellset live = sets[64*k + __builtin_ctzll(b)] & ~dead;
+                int n = live.size();
+                if (n == 0)
+                    return cellset();
+                if (n < bestn) {
+                    best = live;
+                    bestn = n;
+                }
+                /* the bound rarely prunes far from the leaves */
+                if (left <= 4 && (live & used).empty()) {
+                    used = used | live;
+                    if (++lb > left)
+                        return cellset();
+                }
+                common = common & live;
+            }
+        return left == 1 ? common : best;
+    }
+
+    void dfs(const cellset &clues, cellset dead, int n, setmask unhit) {
+        if (done)
+            return;
+        bool all_hit = true;
+        for (int k=0; k<SET_WORDS; k++)
+            if (unhit.w[k])
+                all_hit = false;
+        if (all_hit) {
+            int k;
+            if (unique(clues, &k)) {
+                report(clues);
+                return;
+            }
+            if (k < 0) {
+                /* no room for the set: search its cells unpruned */
+                cellset live = s.diff() & ~dead;
+                if (n < target)
+                    while (!live.empty()) {
+                        cellset c = cellset::cell(live.first());
+                        live = live & ~c;
+                        dfs(clues | c, dead, n+1, unhit);
+                        dead = dead | c;
+                    }
+                return;
+            }
+            unhit.w[k/64] |= 1ULL<<(k%64);
+        }
+        if (n == target)
+            return;
+        cellset live = branch(unhit, dead, target-n);
+        while (!live.empty()) {
+            int c = live.first();
+            live = live & ~cellset::cell(c);
+            setmask child;
+            for (int k=0; k<SET_WORDS; k++)
+                child.w[k] = unhit.w[k] & ~hits[c].w[k];
+            dfs(clues | cellset::cell(c), dead, n+1, child);
+            dead = dead | cellset::cell(c);
+        }
+    }
+
+    /* the sets of this thread not hit by clues */
+    setmask unhit_by(const cellset &clues) {
+        setmask m;
+        for (int k=0; k<SET_WORDS; k++)
+            m.w[k] = 0;
+        for (size_t k=0; k<sets.size(); k++)
+            if ((sets[k] & clues).empty())
+                m.w[k/64] |= 1ULL<<(k%64);
+        return m;
+    }
+
+    /* like dfs from the root, but stop at the given depth and hand
+     * out the nodes */
+    void split(const cellset &clues, cellset dead, int n, int depth,
+               std::vector<task> &out) {
+        setmask unhit = unhit_by(clues);
+        cellset live = branch(unhit, dead, target-n);
+        bool all_hit = true;
+        for (int k=0; k<SET_WORDS; k++)
+            if (unhit.w[k])
+                all_hit = false;
+        if (all_hit || depth == 0) {
+            task t = { clues, dead, n };
+            out.push_back(t);
+            return;
+        }
+        while (!live.empty()) {
+            cellset c = cellset::cell(live.first());
+            live = live & ~c;
+            split(clues | c, dead, n+1, depth-1, out);
+            dead = dead | c;
+        }
+    }
+};
+
+static void search(int threads)
+{
+    std::vector<task> tasks;
+    searcher().split(cellset(), cellset(), 0, 3, tasks);
+    std::atomic<size_t> next(0);
+    std::vector<std::thread> workers;
+    for (int t=0; t<threads; t++)
+        workers.push_back(std::thread([&tasks, &next]() {
+            searcher s;
+            for (size_t i; (i = next++) < tasks.size() && !done; )
+                s.dfs(tasks[i].clues, tasks[i].dead, tasks[i].n,
+                      s.unhit_by(tasks[i].clues));
+        }));
+    for (int t=0; t<threads; t++)
+        workers[t].join();
+}
+
+static void print_set(const cellset &c, bool values)
+{
+    for (int i=0; i<81; i++)
+        std::putchar(c.has(i) ? (values ? '0'+grid[i] : '#') : '.');
+    std::putchar('\n');
+}
+
+int main(int argc, char **argv)
+{
+    const char *file = 0;
+    int threads = std::thread::hardware_concurrency();
+    bool sets_only = false;
+
+    for (int k=1; k<argc; k++) {
+        if (argv[k][0] == '-' && argv[k][1] == 'n')
+            target = std::atoi(argv[k]+2);
+        else if (argv[k][0] == '-' && argv[k][1] == 'j')
+            threads = std::atoi(argv[k]+2);
+        else if (std::strcmp(argv[k], "-1") == 0)
+            first_only = true;
+        else if (std::strcmp(argv[k], "-s") == 0)
+            sets_only = true;
+        else if (argv[k][0] != '-')
+            file = argv[k];
+    }
+    if (!file || target < 1 || target > 81) {
+        std::cout << "\
+Usage:\n\
+  " << argv[0] << " [-n17] [-j8] [-1] [-s] file\n\
+prints all puzzles with n clues (default 17) for each solution grid in file\n\
+-jn ... search with n threads (default: all cores)\n\
+-1 ... stop at the first puzzle found for a grid\n\
+-s ... only print the unavoidable sets found for each grid\n\
+a summary line per grid goes to stderr\n";
+        return 1;
+    }
+    if (threads < 1)
+        threads = 1;
+
+    std::FILE *f = std::fopen(file, "r");
+    if (!f) {
+        std::cerr << "error: can't open " << file << std::endl;
+        return 1;
+    }
+    init_units();
+    char line[256];
+    while (std::fgets(line, sizeof(line), f)) {
+        int n = 0;
+        for (char *p=line; *p && n<81; p++)
+            if (*p >= '1' && *p <= '9')
+                grid[n++] = *p-'0';
+        if (n < 81)
+            continue;
+        {
+            solver s(grid);
+            if (s.solve(grid, 2) != 1) {
+                std::cerr << "error: not a valid grid: " << line;
+                continue;
+            }
+        }
+
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        find_sets(20000, MAX_SETS / 2);
+        if (sets_only) {
+            for (size_t k=0; k<bank.size(); k++)
+                print_set(bank[k], false);
+            std::cout << std::endl;
+            continue;
+        }
+        done = false;
+        checks = 0;
+        found.clear();
+        search(threads);
+        std::sort(found.begin(), found.end());
+        for (size_t k=0; k<found.size(); k++)
+            print_set(found[k], true);
+        double secs = std::chrono::duration<double>(
+            std::chrono::steady_clock::now() - t0).count();
+        std::fprintf(stderr, "%zu puzzles with <=%d clues  %zu sets  "
+                     "%lld checks  %.2fs\n", found.size(), target,
+                     bank.size(), (long long)checks, secs);
+    }
+    std::fclose(f);
+    return 0;
+}
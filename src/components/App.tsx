@@ -51,8 +51,7 @@ function App() {
         
         const isUnique = await sudoku.checkUniqueness();
         if (!isUnique.unique && isUnique.counterExample !== null) {
-            const counterExample = sudoku.modelToGrid(isUnique.counterExample);
-            setCounterExample(counterExample);
+            setCounterExample(isUnique.counterExample);
             setGameOver(true);
         } else {
             setFrozen(false);
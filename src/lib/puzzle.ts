@@ -4,8 +4,16 @@ import MWCRandom from './random';
 
 export type UniquenessResult = {
     unique: boolean,
-    counterExample: Model<"main"> | null
+    // the cell texts of a second solution if the puzzle is not unique
+    counterExample: string[][] | null
 }
+
+// uniqueness results of clue sets already checked, keyed by clueKey(). It is shared by
+// all puzzles of the page, so a clue set met again, after an undo or in a later game, is
+// answered from here instead of the search or Z3. Cleared when it gets too large
+const uniquenessCache: Map<string, UniquenessResult> = new Map();
+const UNIQUENESS_CACHE_SIZE = 100000;
+
 abstract class Puzzle {
     // Puzzle is the base class for all types of puzzles. It contains the 
     // Z3 solver common methods
@@ -15,6 +23,8 @@ abstract class Puzzle {
     protected assertionsMap: AstMap<"main", Arith, Arith> | null;
     protected removedAssertions: [Arith, Arith][] = [];
     protected originalSolutionRestriction: Bool | null;
+    public cacheProbes: number = 0;
+    public cacheHits: number = 0;
 
     constructor(seed: number) {
         this.random = new MWCRandom(seed);
@@ -82,24 +92,53 @@ abstract class Puzzle {
     abstract undo(): void;
     // undo undoes the last removal
 
+    abstract clueKey(): string;
+    // clueKey identifies the current set of assertions and the original solution, used to
+    // cache uniqueness results across puzzles
+
+    abstract modelToGrid(model: Model<"main">): string[][];
+    // modelToGrid turns a model of the solver into the cell texts of the board
+
+    protected differentSolution(): string[][] | null | undefined {
+        // differentSolution looks for a solution other than the original one without Z3.
+        // Puzzles that can search their empty cells directly override it and return the
+        // other solution, or null if there is none. undefined leaves the check to Z3
+        return undefined;
+    }
+
 
 
     public async checkUniqueness(): Promise<UniquenessResult> {
-        // checkUniqueness checks if the puzzle is unique. This is done by adding a new constraint
-        // that the puzzle is not equal to the current solution and then checking if the solver
-        // is satisfiable. If it is, then the puzzle is not unique
+        // checkUniqueness checks if the puzzle is unique. Puzzles with a differentSolution search
+        // use it; otherwise a new constraint that the puzzle is not equal to the current solution
+        // is added and the solver checked for satisfiability. If it is, then the puzzle is not unique
         if (this.solver === null || this.Z3 === null || this.assertionsMap === null || this.originalSolutionRestriction === null) {
             throw new Error("Solver not initialized");
         }
-        let assertions = this.getAssertionVector();
-        // add the new constraint to the assertion array
-        assertions.push(this.originalSolutionRestriction);
-        // check if the solver is satisfiable
-        let newSolution = await this.solver.check(assertions);
-        if (newSolution === "sat") {
-            return { unique: false, counterExample: this.solver.model() };
+        let key = this.clueKey();
+        this.cacheProbes++;
+        let cached = uniquenessCache.get(key);
+        if (cached !== undefined) {
+            this.cacheHits++;
+            return cached;
+        }
+        let result: UniquenessResult = { unique: true, counterExample: null };
+        let other = this.differentSolution();
+        if (other !== undefined) {
+            result = { unique: other === null, counterExample: other };
+        } else {
+            let assertions = this.getAssertionVector();
+            // add the new constraint to the assertion array
+            assertions.push(this.originalSolutionRestriction);
+            // check if the solver is satisfiable
+            let newSolution = await this.solver.check(assertions);
+            if (newSolution === "sat") {
+                result = { unique: false, counterExample: this.modelToGrid(this.solver.model()) };
+            }
         }
-        return { unique: true, counterExample: null };
+        if (uniquenessCache.size >= UNIQUENESS_CACHE_SIZE) uniquenessCache.clear();
+        uniquenessCache.set(key, result);
+        return result;
     }
 
 
@@ -8,12 +8,36 @@ const NBSP = '\xa0'; // nonbreaking space
 export const BOARD_SIZE = 9;
 export const BOX_SIZE = 3;
 
+// Zobrist keys for every (cell, value) pair, as two 32 bit halves. They come from a
+// fixed xorshift32 stream (MWCRandom repeats far too soon for this) so the hash of a
+// clue set is the same for every puzzle
+const ZOBRIST: [number, number][][] = (() => {
+    let x = 2463534242;
+    let next = () => {
+        x ^= x << 13;
+        x ^= x >>> 17;
+        x ^= x << 5;
+        return x >>> 0;
+    };
+    return Array.from({ length: BOARD_SIZE * BOARD_SIZE }, () =>
+        Array.from({ length: BOARD_SIZE + 1 }, (): [number, number] => [next(), next()]));
+})();
+
 export class Sudoku extends Puzzle {
     private cells: Arith[][];
     minForm: string[][];
+    private solution: number[];
+    private cleared: boolean[];
+    private hash: [number, number];
+    private solutionKey: string;
     constructor(seed: number) {
         super(seed);
         this.cells = [];
+        this.solution = [];
+        // every cell is cleared until addAssertions sets its clue
+        this.cleared = Array(BOARD_SIZE * BOARD_SIZE).fill(true);
+        this.hash = [0, 0];
+        this.solutionKey = "";
         this.minForm = [];
         for (let i = 0; i < BOARD_SIZE; i++) {
             this.minForm.push([]);
@@ -92,7 +116,96 @@ export class Sudoku extends Puzzle {
             let val = puzzle[i];
             this.assertionsMap.set(this.cells[row][col], this.Z3.Int.val(val));
             this.minForm[row][col] = min[i];
+            this.solution[i] = parseInt(val);
+            this.toggleHash([row, col]);
+        }
+        this.solutionKey = this.clueKey() + "/";
+    }
+
+    private toggleHash(val: [number, number]): void {
+        // add or remove the (cell, value) pair of an original clue from the zobrist hash
+        // and flip whether the cell is cleared
+        let i = val[0] * BOARD_SIZE + val[1];
+        this.cleared[i] = !this.cleared[i];
+        let [hi, lo] = ZOBRIST[i][this.solution[i]];
+        this.hash = [(this.hash[0] ^ hi) >>> 0, (this.hash[1] ^ lo) >>> 0];
+    }
+
+    public clueKey(): string {
+        // the hash of the full grid goes first: two puzzles with the same clues but different
+        // solutions must not share a counterexample
+        return this.solutionKey + this.hash[0].toString(16) + ":" + this.hash[1].toString(16);
+    }
+
+    protected differentSolution(): string[][] | null {
+        // search the cleared cells for a filling other than the solution: the cell with the
+        // fewest candidates first, values that differ from the solution before its own, and
+        // stop at the first grid that differs anywhere. The filled cells stay fixed, so the
+        // few holes of the early game are checked in microseconds
+        let rows: number[] = Array(BOARD_SIZE).fill(0);
+        let cols: number[] = Array(BOARD_SIZE).fill(0);
+        let boxes: number[] = Array(BOARD_SIZE).fill(0);
+        let box = (i: number) => Math.floor(i / BOARD_SIZE / BOX_SIZE) * BOX_SIZE + Math.floor(i % BOARD_SIZE / BOX_SIZE);
+        let all = (1 << (BOARD_SIZE + 1)) - 2;
+        let grid = this.solution.slice();
+        let holes: number[] = [];
+        for (let i = 0; i < BOARD_SIZE * BOARD_SIZE; i++) {
+            if (this.cleared[i]) {
+                holes.push(i);
+                continue;
+            }
+            let bit = 1 << grid[i];
+            rows[Math.floor(i / BOARD_SIZE)] |= bit;
+            cols[i % BOARD_SIZE] |= bit;
+            boxes[box(i)] |= bit;
         }
+        let candidates = (i: number) => all & ~(rows[Math.floor(i / BOARD_SIZE)] | cols[i % BOARD_SIZE] | boxes[box(i)]);
+        let count = (m: number) => {
+            let n = 0;
+            for (; m; m &= m - 1) n++;
+            return n;
+        };
+
+        let search = (n: number, differs: boolean): boolean => {
+            if (n === 0) return differs;
+            let best = 0, fewest = BOARD_SIZE + 1;
+            for (let k = 0; k < n && fewest > 1; k++) {
+                let c = count(candidates(holes[k]));
+                if (c < fewest) {
+                    fewest = c;
+                    best = k;
+                }
+            }
+            if (fewest === 0) return false;
+            let i = holes[best];
+            holes[best] = holes[n - 1];
+            holes[n - 1] = i;
+            let own = this.solution[i];
+            let m = candidates(i);
+            let values: number[] = [];
+            for (let v = 1; v <= BOARD_SIZE; v++) {
+                if (v !== own && (m & (1 << v))) values.push(v);
+            }
+            if (m & (1 << own)) values.push(own);
+            let row = Math.floor(i / BOARD_SIZE), col = i % BOARD_SIZE, b = box(i);
+            for (let v of values) {
+                rows[row] |= 1 << v;
+                cols[col] |= 1 << v;
+                boxes[b] |= 1 << v;
+                grid[i] = v;
+                let found = search(n - 1, differs || v !== own);
+                rows[row] ^= 1 << v;
+                cols[col] ^= 1 << v;
+                boxes[b] ^= 1 << v;
+                if (found) return true;
+            }
+            grid[i] = own;
+            return false;
+        };
+
+        if (!search(holes.length, false)) return null;
+        return Array.from({ length: BOARD_SIZE }, (_, row) =>
+            grid.slice(row * BOARD_SIZE, (row + 1) * BOARD_SIZE).map(v => v.toString()));
     }
 
     private randomSwaps(pair: [string, string]): [string, string] {
@@ -137,6 +250,7 @@ export class Sudoku extends Puzzle {
         if (!this.assertionsMap.has(key)) throw new Error("No such assertion to delete");
         this.removedAssertions.push([key, this.assertionsMap.get(key) as Arith]);
         this.assertionsMap.delete(key);
+        this.toggleHash(val);
     }
 
     public undo() {
@@ -146,6 +260,8 @@ export class Sudoku extends Puzzle {
         if (this.removedAssertions.length === 0) throw new Error("No assertions to undo");
         let [key, value] = this.removedAssertions.pop() as [Arith, Arith];
         this.assertionsMap.set(key, value);
+        let i = this.cells.flat().indexOf(key);
+        this.toggleHash([Math.floor(i / BOARD_SIZE), i % BOARD_SIZE]);
     }
 
     public boardToString(): string {